@@ -0,0 +1,46 @@
+#include "ConcurrentStateTable.hpp"
+
+namespace ugv_nav4d
+{
+
+constexpr int ConcurrentStateTable::emptyId;
+constexpr int ConcurrentStateTable::pendingId;
+constexpr size_t ConcurrentStateTable::blocksPerChunk;
+
+ConcurrentStateTable::ConcurrentStateTable(int numAngles) : numAngles(numAngles), numBlocks(0), numStates(0)
+{
+}
+
+void ConcurrentStateTable::reserve(size_t minBlocks)
+{
+    while(chunks.size() * blocksPerChunk < minBlocks)
+        chunks.emplace_back(new std::atomic<int>[blocksPerChunk * numAngles]);
+}
+
+std::atomic<int>* ConcurrentStateTable::createBlock()
+{
+    const size_t i = numBlocks.fetch_add(1, std::memory_order_relaxed);
+    assert(i < chunks.size() * blocksPerChunk && "ConcurrentStateTable: reserve() was not called");
+    //the block is published by the caller, thus relaxed stores are enough
+    std::atomic<int>* block = &chunks[i / blocksPerChunk][(i % blocksPerChunk) * numAngles];
+    for(int theta = 0; theta < numAngles; ++theta)
+        block[theta].store(emptyId, std::memory_order_relaxed);
+    return block;
+}
+
+void ConcurrentStateTable::clear()
+{
+    numBlocks.store(0, std::memory_order_relaxed);
+    numStates.store(0, std::memory_order_release);
+}
+
+int ConcurrentStateTable::find(const std::atomic<int>* block, int theta) const
+{
+    assert(theta >= 0 && theta < numAngles);
+    if(!block)
+        return -1;
+    const int id = block[theta].load(std::memory_order_acquire);
+    return id >= 0 ? id : -1;
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ugv_nav4d
+{
+
+/** Maps (position, theta) pairs to sbpl state ids.
+ *
+ *  Every position that is touched by the search owns a block of id slots, one per orientation,
+ *  that is indexed directly by DiscreteTheta::getTheta(). Thus a lookup is a single array access.
+ *  The blocks are carved from chunks, positions without states do not use any memory.
+ *  Lookups, insertions and the creation of blocks are lock-free and may be called concurrently.
+ *  New ids are assigned consecutively using an atomic counter.
+ *  The table does not grow during concurrent use. reserve() has to be called beforehand
+ *  for all blocks that may be created. */
+class ConcurrentStateTable
+{
+public:
+    /** @param numAngles number of discrete orientations, all thetas are in [0, numAngles) */
+    explicit ConcurrentStateTable(int numAngles);
+
+    /** Makes room for at least @p minBlocks blocks in total.
+     *  Not thread-safe, must not run concurrently with any other method. */
+    void reserve(size_t minBlocks);
+
+    /** @return a new block without any states. The number of blocks must not exceed the reserved capacity */
+    std::atomic<int>* createBlock();
+
+    /** Removes all states and blocks and restarts the ids at 0.
+     *  The chunks are kept for reuse, thus no slot is visited. Not thread-safe. */
+    void clear();
+
+    /** @return the id of the state or -1 if it does not exist */
+    int find(const std::atomic<int>* block, int theta) const;
+
+    /** Returns the id of the state (@p block, @p theta).
+     *  If the state does not exist yet, a new id is assigned and @p create(id) is called exactly once.
+     *  Other threads that look up the same state wait until @p create returned. */
+    template <class Create>
+    int findOrInsert(std::atomic<int>* block, int theta, Create&& create);
+
+    /** @return the number of states. The ids of all states are in [0, size()) */
+    size_t size() const
+    {
+        return numStates.load(std::memory_order_acquire);
+    }
+
+    /** @return the number of blocks created since the last clear() */
+    size_t getNumBlocks() const
+    {
+        return numBlocks.load(std::memory_order_relaxed);
+    }
+
+    /** @return the memory used by the chunks in bytes */
+    size_t getMemoryUsage() const
+    {
+        return chunks.size() * blocksPerChunk * numAngles * sizeof(std::atomic<int>);
+    }
+
+private:
+    static constexpr int emptyId = -1;
+    static constexpr int pendingId = -2;
+    static constexpr size_t blocksPerChunk = 1024;
+
+    const int numAngles;
+    std::vector<std::unique_ptr<std::atomic<int>[]>> chunks;
+    std::atomic<size_t> numBlocks;
+    std::atomic<size_t> numStates;
+};
+
+template <class Create>
+int ConcurrentStateTable::findOrInsert(std::atomic<int>* block, int theta, Create&& create)
+{
+    assert(block && theta >= 0 && theta < numAngles);
+    std::atomic<int>& s = block[theta];
+    int id = s.load(std::memory_order_acquire);
+    if(id >= 0)
+        return id;
+
+    if(id == emptyId && s.compare_exchange_strong(id, pendingId, std::memory_order_acq_rel))
+    {
+        id = static_cast<int>(numStates.fetch_add(1, std::memory_order_acq_rel));
+        create(id);
+        s.store(id, std::memory_order_release);
+        return id;
+    }
+
+    //another thread is creating the state
+    while((id = s.load(std::memory_order_acquire)) == pendingId)
+        std::this_thread::yield();
+    return id;
+}
+
+}
@@ -1,6 +1,9 @@
 #include "Dijkstra.hpp"
 #include <traversability_generator3d/TraversabilityConfig.hpp>
 #include <maps/grid/TraversabilityMap3d.hpp>
+#include <cstdint>
+#include <atomic>
+#include <omp.h>
 
 using namespace maps::grid;
 
@@ -56,6 +59,116 @@ void Dijkstra::computeCost(const TraversabilityNodeBase* source,
     }
 }
 
+void Dijkstra::computeCost(const traversability_generator3d::TravGenNode* source,
+                           std::vector<double>& outDistances, size_t numNodes, double maxDist,
+                           const traversability_generator3d::TraversabilityConfig& config)
+{
+    ResumableDijkstra dijkstra;
+    dijkstra.reset(source, numNodes, maxDist, config);
+    dijkstra.expandAll();
+    dijkstra.takeDistances(outDistances);
+    //ids beyond numNodes are never queried by the caller, but the size is part of the contract
+    outDistances.resize(std::max(outDistances.size(), numNodes), maxDist);
+}
+
+void Dijkstra::computeCostParallel(const traversability_generator3d::TravGenNode* source,
+                                   std::vector<double>& outDistances, size_t numNodes, double maxDist,
+                                   double bucketWidth,
+                                   const traversability_generator3d::TraversabilityConfig& config)
+{
+    typedef traversability_generator3d::TravGenNode TravGenNode;
+    //node and the distance it had when it was queued
+    typedef std::pair<const TravGenNode*, double> Entry;
+
+    bucketWidth = std::max(bucketWidth, config.gridResolution);
+
+    std::vector<std::atomic<double>> distances(numNodes);
+    for(std::atomic<double>& d : distances)
+        d.store(maxDist, std::memory_order_relaxed);
+
+    std::vector<std::vector<Entry>> buckets;
+    auto push = [&](const TravGenNode* node, double dist)
+    {
+        const size_t bucket = static_cast<size_t>(dist / bucketWidth);
+        if(bucket >= buckets.size())
+            buckets.resize(bucket + 1);
+        buckets[bucket].emplace_back(node, dist);
+    };
+
+    distances[source->getUserData().id].store(0.0);
+    push(source, 0.0);
+
+    std::vector<std::vector<Entry>> threadRequests(omp_get_max_threads());
+
+    for(size_t b = 0; b < buckets.size(); ++b)
+    {
+        //relax the bucket until no node is re-inserted into it
+        while(!buckets[b].empty())
+        {
+            std::vector<Entry> frontier;
+            frontier.swap(buckets[b]);
+
+            #pragma omp parallel
+            {
+                std::vector<Entry> &requests = threadRequests[omp_get_thread_num()];
+
+                #pragma omp for schedule(dynamic, 64)
+                for(size_t i = 0; i < frontier.size(); ++i)
+                {
+                    const TravGenNode* u = frontier[i].first;
+                    const double dist = frontier[i].second;
+                    //stale entry, the node has been reached on a shorter path in the meantime
+                    if(distances[u->getUserData().id].load(std::memory_order_relaxed) < dist)
+                        continue;
+
+                    const Eigen::Vector3d uPos(u->getIndex().x() * config.gridResolution,
+                                               u->getIndex().y() * config.gridResolution,
+                                               u->getHeight());
+
+                    for(TraversabilityNodeBase *vBase : u->getConnections())
+                    {
+                        if(vBase->getType() != TraversabilityNodeBase::TRAVERSABLE)
+                            continue;
+
+                        const TravGenNode* v = static_cast<const TravGenNode*>(vBase);
+                        const size_t vId = v->getUserData().id;
+                        if(vId >= numNodes)
+                            continue;
+
+                        const Eigen::Vector3d vPos(v->getIndex().x() * config.gridResolution,
+                                                   v->getIndex().y() * config.gridResolution,
+                                                   v->getHeight());
+                        const double distance_through_u = dist + getHeuristicDistance(vPos, uPos, config);
+
+                        //atomic min
+                        double current = distances[vId].load(std::memory_order_relaxed);
+                        while(distance_through_u < current)
+                        {
+                            if(distances[vId].compare_exchange_weak(current, distance_through_u))
+                            {
+                                requests.emplace_back(v, distance_through_u);
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            for(std::vector<Entry> &requests : threadRequests)
+            {
+                for(const Entry &e : requests)
+                    push(e.first, e.second);
+                requests.clear();
+            }
+        }
+        std::vector<Entry>().swap(buckets[b]);
+    }
+
+    outDistances.resize(numNodes);
+    for(size_t i = 0; i < numNodes; ++i)
+        outDistances[i] = distances[i].load(std::memory_order_relaxed);
+}
+
 double Dijkstra::getHeuristicDistance(const Eigen::Vector3d& a, const Eigen::Vector3d& b,
                             const traversability_generator3d::TraversabilityConfig& config)
 {
@@ -63,4 +176,133 @@ double Dijkstra::getHeuristicDistance(const Eigen::Vector3d& a, const Eigen::Vec
 }
 
     
+ResumableDijkstra::ResumableDijkstra() :
+    maxDist(0), bucketWidth(0), initialized(false), currentBucket(0), currentIndex(0)
+{
+}
+
+void ResumableDijkstra::reset(const traversability_generator3d::TravGenNode* source, size_t numNodes, double maxDist,
+                              const traversability_generator3d::TraversabilityConfig& config)
+{
+    this->config = config;
+    this->maxDist = maxDist;
+    //every edge is at least one grid cell long, thus nodes inside the current bucket
+    //cannot improve each other.
+    bucketWidth = config.gridResolution;
+
+    distances.assign(numNodes, maxDist);
+    settled.assign(numNodes, 0);
+    buckets.clear();
+    currentBucket = 0;
+    currentIndex = 0;
+
+    const size_t sourceId = source->getUserData().id;
+    ensureSize(sourceId);
+    distances[sourceId] = 0.0;
+    buckets.resize(1);
+    buckets[0].push_back(source);
+    initialized = true;
+}
+
+void ResumableDijkstra::ensureSize(size_t id)
+{
+    if(id >= distances.size())
+    {
+        distances.resize(id + 1, maxDist);
+        settled.resize(id + 1, 0);
+    }
+}
+
+bool ResumableDijkstra::settleNext()
+{
+    typedef traversability_generator3d::TravGenNode TravGenNode;
+
+    const TravGenNode* u = nullptr;
+    while(!u)
+    {
+        if(currentBucket >= buckets.size())
+            return false;
+
+        if(currentIndex >= buckets[currentBucket].size())
+        {
+            //free the memory of processed buckets early, the queue might be large on big maps
+            std::vector<const TravGenNode*>().swap(buckets[currentBucket]);
+            ++currentBucket;
+            currentIndex = 0;
+            continue;
+        }
+
+        const TravGenNode* candidate = buckets[currentBucket][currentIndex++];
+        //stale entry, the node has been reached on a shorter path before
+        if(!settled[candidate->getUserData().id])
+            u = candidate;
+    }
+
+    const size_t uId = u->getUserData().id;
+    settled[uId] = 1;
+
+    const double dist = distances[uId];
+    const Eigen::Vector3d uPos(u->getIndex().x() * config.gridResolution,
+                               u->getIndex().y() * config.gridResolution,
+                               u->getHeight());
+
+    for(TraversabilityNodeBase *vBase : u->getConnections())
+    {
+        //skip all non traversable nodes. They will retain the maximum cost.
+        if(vBase->getType() != TraversabilityNodeBase::TRAVERSABLE)
+            continue;
+
+        const TravGenNode* v = static_cast<const TravGenNode*>(vBase);
+        const size_t vId = v->getUserData().id;
+        ensureSize(vId);
+        if(settled[vId])
+            continue;
+
+        const Eigen::Vector3d vPos(v->getIndex().x() * config.gridResolution,
+                                   v->getIndex().y() * config.gridResolution,
+                                   v->getHeight());
+
+        const double distance_through_u = dist + Dijkstra::getHeuristicDistance(vPos, uPos, config);
+        if(distance_through_u < distances[vId])
+        {
+            distances[vId] = distance_through_u;
+            //rounding errors might result in a bucket smaller than the current one.
+            //Such nodes are processed as part of the current bucket.
+            const size_t bucket = std::max(currentBucket, static_cast<size_t>(distance_through_u / bucketWidth));
+            if(bucket >= buckets.size())
+                buckets.resize(bucket + 1);
+            buckets[bucket].push_back(v);
+        }
+    }
+    return true;
+}
+
+double ResumableDijkstra::getDistance(const traversability_generator3d::TravGenNode* node)
+{
+    const size_t id = node->getUserData().id;
+    ensureSize(id);
+    while(!settled[id])
+    {
+        if(!settleNext())
+            break;
+    }
+    return distances[id];
+}
+
+void ResumableDijkstra::expandAll()
+{
+    while(settleNext())
+    {
+    }
+}
+
+void ResumableDijkstra::takeDistances(std::vector<double>& outDistances)
+{
+    outDistances.swap(distances);
+    distances.clear();
+    settled.clear();
+    buckets.clear();
+    initialized = false;
+}
+
 }
@@ -1,7 +1,10 @@
 #pragma once
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
 #include <base/Eigen.hpp>
 #include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <traversability_generator3d/TravGenNode.hpp>
 
 namespace maps { namespace grid 
 {
@@ -24,9 +27,81 @@ public:
                             std::unordered_map<const maps::grid::TraversabilityNodeBase*, double> &outDistances,
                             const traversability_generator3d::TraversabilityConfig& config);
 
+    /** Computes the heuristic cost from @p source to all reachable nodes.
+     *  Nodes are indexed by their id (getUserData().id) and a monotone bucket queue is used
+     *  instead of a tree based priority queue. The bucket width is config.gridResolution, which
+     *  is a lower bound for the length of every edge. Thus all nodes in the lowest bucket are final
+     *  and the result is identical to the one of the hash map based version above.
+     *  @param outDistances distance indexed by node id. Is resized to @p numNodes.
+     *                      Unreachable nodes are set to @p maxDist
+     *  @param numNodes the number of nodes in the map, i.e. one more than the largest id */
+    static void computeCost(const traversability_generator3d::TravGenNode* source,
+                            std::vector<double> &outDistances, size_t numNodes, double maxDist,
+                            const traversability_generator3d::TraversabilityConfig& config);
+
+    /** Parallel version of computeCost() based on delta-stepping.
+     *  The nodes of one bucket are relaxed concurrently using all available OpenMP threads.
+     *  Nodes may be relaxed several times, therefore this is only faster than the sequential
+     *  version on very large maps.
+     *  @param bucketWidth width of the delta-stepping buckets in meters. Larger values increase
+     *                     the parallelism but also the amount of redundant work.
+     *                     Values smaller than config.gridResolution are clamped. */
+    static void computeCostParallel(const traversability_generator3d::TravGenNode* source,
+                                    std::vector<double> &outDistances, size_t numNodes, double maxDist,
+                                    double bucketWidth,
+                                    const traversability_generator3d::TraversabilityConfig& config);
+
 private:
+    friend class ResumableDijkstra;
     static double getHeuristicDistance(const Eigen::Vector3d& a, const Eigen::Vector3d& b,
                                        const traversability_generator3d::TraversabilityConfig& config);
 };
+
+/** A bucket queue based Dijkstra search that can be interrupted and resumed.
+ *  Distances are only computed as far as needed to answer the queries, i.e. the search
+ *  stops as soon as the queried node is settled. Subsequent queries continue the search
+ *  where the previous one stopped. */
+class ResumableDijkstra
+{
+public:
+    ResumableDijkstra();
+
+    /** Starts a new search from @p source. No nodes are expanded.
+     *  @param numNodes initial size of the internal arrays. They grow if nodes with larger ids are encountered. */
+    void reset(const traversability_generator3d::TravGenNode* source, size_t numNodes, double maxDist,
+               const traversability_generator3d::TraversabilityConfig& config);
+
+    /** @return the distance from the source to @p node or maxDist if @p node is not reachable.
+     *          Resumes the search until @p node is settled. */
+    double getDistance(const traversability_generator3d::TravGenNode* node);
+
+    /** Continues the search until all reachable nodes are settled */
+    void expandAll();
+
+    /** Moves the distances of all nodes into @p outDistances. The search has to be reset afterwards. */
+    void takeDistances(std::vector<double>& outDistances);
+
+    bool isInitialized() const
+    {
+        return initialized;
+    }
+
+private:
+    /** Settles the next node of the queue.
+     *  @return false if the queue is empty */
+    bool settleNext();
+    void ensureSize(size_t id);
+
+    traversability_generator3d::TraversabilityConfig config;
+    double maxDist;
+    double bucketWidth;
+    bool initialized;
+
+    std::vector<double> distances;
+    std::vector<uint8_t> settled;
+    std::vector<std::vector<const traversability_generator3d::TravGenNode*>> buckets;
+    size_t currentBucket;
+    size_t currentIndex;
+};
     
 } 
\ No newline at end of file
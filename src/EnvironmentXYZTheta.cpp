@@ -9,6 +9,7 @@
 #include "PathStatistic.hpp"
 #include "Dijkstra.hpp"
 #include <limits>
+#include <algorithm>
 #include <base-logging/Logging.hpp>
 
 using namespace std;
@@ -27,53 +28,101 @@ namespace ugv_nav4d
         throw std::runtime_error("meeeeh"); \
     }
 
-EnvironmentXYZTheta::EnvironmentXYZTheta(std::shared_ptr<MLGrid> mlsGrid,
+/** Per thread buffers used while generating successors. They keep their capacity
+ *  between calls, thus the steady state expansion in GetSuccs() does not allocate. */
+struct SuccessorScratch
+{
+    std::vector<const traversability_generator3d::TravGenNode*> nodesOnObstPath;
+    std::vector<EnvironmentXYZTheta::SuccessorCandidate> candidates;
+};
+
+static thread_local SuccessorScratch successorScratch;
+
+/** State of one of the trajectories that are generated by EnvironmentXYZTheta::getTrajectories() */
+struct TrajectoryBuilder
+{
+    TrajectoryBuilder(std::vector<SubTrajectory>* result, bool setZToZero, const Eigen::Vector3d& start) :
+        result(result), setZToZero(setZToZero), start(start), goalPositionUpdated(false)
+    {
+    }
+
+    std::vector<SubTrajectory>* result;
+    bool setZToZero;
+    Eigen::Vector3d start;
+    base::Trajectory curPart;
+    std::vector<base::Vector3d> positions;
+    bool goalPositionUpdated;
+};
+
+//FIXME this should be a config value?!
+static const double maxDist = 99999999; //big enough to never occur in reality. Small enough to not cause overflows when used by accident.
+
+/** The generators only read the grid, but their interface takes a mutable one */
+static std::shared_ptr<EnvironmentXYZTheta::MLGrid> generatorGrid(const std::shared_ptr<const EnvironmentXYZTheta::MLGrid>& mlsGrid)
+{
+    return std::const_pointer_cast<EnvironmentXYZTheta::MLGrid>(mlsGrid);
+}
+
+EnvironmentXYZTheta::EnvironmentXYZTheta(std::shared_ptr<const MLGrid> mlsGrid,
                                          const traversability_generator3d::TraversabilityConfig& travConf,
                                          const SplinePrimitivesConfig& primitiveConfig,
-                                         const Mobility& mobilityConfig) :
+                                         const Mobility& mobilityConfig,
+                                         const std::string& motionCacheDirectory) :
     travGen(travConf), obsGen(travConf)
     , mlsGrid(mlsGrid)
+    , stateTable(primitiveConfig.numAngles)
     , availableMotions(primitiveConfig, mobilityConfig)
+    , motionCheckBlocksUsed(0)
+    , motionCheckGeneration(1)
+    , motionChecksUsed(0)
     , startThetaNode(nullptr)
     , startXYZNode(nullptr)
     , goalThetaNode(nullptr)
     , goalXYZNode(nullptr)
     , obstacleStartNode(nullptr)
+    , usePathStatistics(false)
+    , startCostValid(false)
+    , parallelHeuristic(false)
+    , deltaSteppingBucketWidth(0)
+    , lazyHeuristic(false)
+    , startHeuristicRequired(false)
+    , goalCostNode(nullptr)
+    , goalCostNumNodes(0)
+    , searchGraphOutdated(false)
+    , mapGeneration(1)
+    , expandedGeneration(0)
     , travConf(travConf)
     , primitiveConfig(primitiveConfig)
     , mobilityConfig(mobilityConfig)
 {
     numAngles = primitiveConfig.numAngles;
-    travGen.setMLSGrid(mlsGrid);
-    obsGen.setMLSGrid(mlsGrid);
-    searchGrid.setResolution(Eigen::Vector2d(travConf.gridResolution, travConf.gridResolution));
-    searchGrid.extend(travGen.getTraversabilityMap().getNumCells());
+    travGen.setMLSGrid(generatorGrid(mlsGrid));
+    obsGen.setMLSGrid(generatorGrid(mlsGrid));
     robotHalfSize << travConf.robotSizeX / 2, travConf.robotSizeY / 2, travConf.robotHeight/2;
+    availableMotions.setCacheDirectory(motionCacheDirectory);
     if(mlsGrid)
     {
         availableMotions.computeMotions(mlsGrid->getResolution().x(), travConf.gridResolution);
+        availableMotions.computeFootprints(travConf);
     }
 }
 
 void EnvironmentXYZTheta::clear()
 {
-    //clear the search grid
-    for(maps::grid::LevelList<XYZNode *> &l : searchGrid)
+    //clear the search space. The nodes live in arenas, which keep their memory for the next plan
+    for(std::atomic<XYZNode *> &node : travNodeIdToXYZNode)
     {
-        for(XYZNode *n : l)
-        {
-            for(auto &tn : n->getUserData().thetaToNodes)
-            {
-                delete tn.second;
-            }
-            delete n;
-        }
-        l.clear();
+        node.store(nullptr, std::memory_order_relaxed);
     }
-    searchGrid.clear();
-
+    xyzNodeArena.clear();
+    thetaNodeArena.clear();
+    stateTable.clear();
     idToHash.clear();
     travNodeIdToDistance.clear();
+    lazyGoalDistance = ResumableDijkstra();
+    startCostValid = false;
+    goalCostNode = nullptr;
+    searchGraphOutdated = false;
 
     startThetaNode = nullptr;
     startXYZNode = nullptr;
@@ -81,15 +130,29 @@ void EnvironmentXYZTheta::clear()
     goalThetaNode = nullptr;
     goalXYZNode = nullptr;
 
-    for(int *p: StateID2IndexMapping)
-    {
-        delete[] p;
-    }
+    //the rows are owned by stateIndexRowArena. The mapping has to be empty before the
+    //destructor of DiscreteSpaceInformation runs, because it deletes all rows
     StateID2IndexMapping.clear();
+    stateIndexRowArena.clear();
 }
 
 
 
+void EnvironmentXYZTheta::clearForReplanning(size_t maxStates)
+{
+    if(searchGraphOutdated || (maxStates > 0 && stateTable.size() > maxStates))
+    {
+        clear();
+        return;
+    }
+
+    startCostValid = false;
+    startThetaNode = nullptr;
+    startXYZNode = nullptr;
+    goalThetaNode = nullptr;
+    goalXYZNode = nullptr;
+}
+
 EnvironmentXYZTheta::~EnvironmentXYZTheta()
 {
     clear();
@@ -99,9 +162,13 @@ void EnvironmentXYZTheta::setInitialPatch(const Eigen::Affine3d& ground2Mls, dou
 {
     travGen.setInitialPatch(ground2Mls, patchRadius);
     obsGen.setInitialPatch(ground2Mls, patchRadius);
+    obsGen.clearDistanceLayer();
+    clearMotionChecks();
+    searchGraphOutdated = true;
+    ++mapGeneration;
 }
 
-void EnvironmentXYZTheta::updateMap(shared_ptr< ugv_nav4d::EnvironmentXYZTheta::MLGrid > mlsGrid)
+void EnvironmentXYZTheta::updateMap(shared_ptr< const ugv_nav4d::EnvironmentXYZTheta::MLGrid > mlsGrid)
 {
     if(this->mlsGrid && this->mlsGrid->getResolution() != mlsGrid->getResolution())
         throw std::runtime_error("EnvironmentXYZTheta::updateMap : Error got MLSMap with different resolution");
@@ -109,20 +176,74 @@ void EnvironmentXYZTheta::updateMap(shared_ptr< ugv_nav4d::EnvironmentXYZTheta::
     if(!this->mlsGrid)
     {
         availableMotions.computeMotions(mlsGrid->getResolution().x(), travConf.gridResolution);
+        availableMotions.computeFootprints(travConf);
     }
-    travGen.setMLSGrid(mlsGrid);
-    obsGen.setMLSGrid(mlsGrid);
+    travGen.setMLSGrid(generatorGrid(mlsGrid));
+    obsGen.setMLSGrid(generatorGrid(mlsGrid));
+    clearMotionChecks();
     this->mlsGrid = mlsGrid;
+    ++mapGeneration;
 
     clear();
 }
 
-EnvironmentXYZTheta::XYZNode* EnvironmentXYZTheta::createNewXYZState(traversability_generator3d::TravGenNode* travNode)
+void EnvironmentXYZTheta::updateMap(shared_ptr< const ugv_nav4d::EnvironmentXYZTheta::MLGrid > mlsGrid, const Eigen::AlignedBox3d& changedRegion)
 {
-    XYZNode *xyzNode = new XYZNode(travNode->getHeight(), travNode->getIndex());
-    xyzNode->getUserData().travNode = travNode;
-    searchGrid.at(travNode->getIndex()).insert(xyzNode);
+    if(!this->mlsGrid || this->mlsGrid->getResolution() != mlsGrid->getResolution() ||
+       this->mlsGrid->getNumCells() != mlsGrid->getNumCells() ||
+       !this->mlsGrid->getLocalFrame().isApprox(mlsGrid->getLocalFrame()))
+    {
+        updateMap(mlsGrid);
+        return;
+    }
+
+    if(changedRegion.isEmpty())
+    {
+        //nothing changed, only take over the new grid (an empty cell range resets no node)
+        travGen.updateRegion(generatorGrid(mlsGrid), maps::grid::Index(0, 0), maps::grid::Index(-1, -1));
+        obsGen.updateRegion(generatorGrid(mlsGrid), maps::grid::Index(0, 0), maps::grid::Index(-1, -1));
+        this->mlsGrid = mlsGrid;
+        return;
+    }
+
+    //the obstacle and step checks of a node look at the whole robot footprint around it
+    const double robotRadius = std::sqrt(travConf.robotSizeX * travConf.robotSizeX + travConf.robotSizeY * travConf.robotSizeY) / 2.0;
+    const Eigen::Vector3d margin(robotRadius + travConf.gridResolution, robotRadius + travConf.gridResolution, 0);
 
+    maps::grid::Index travMin, travMax, obstMin, obstMax;
+    travGen.getTraversabilityMap().toGrid(changedRegion.min() - margin, travMin, false);
+    travGen.getTraversabilityMap().toGrid(changedRegion.max() + margin, travMax, false);
+    obsGen.getTraversabilityMap().toGrid(changedRegion.min() - margin, obstMin, false);
+    obsGen.getTraversabilityMap().toGrid(changedRegion.max() + margin, obstMax, false);
+
+    //the nodes of the region are deleted and generated again by the next expandMap()
+    const size_t numTravNodes = travGen.updateRegion(generatorGrid(mlsGrid), travMin, travMax);
+    const size_t numObstNodes = obsGen.updateRegion(generatorGrid(mlsGrid), obstMin, obstMax);
+    clearMotionChecks();
+    this->mlsGrid = mlsGrid;
+    ++mapGeneration;
+
+    //the states may point to deleted trav nodes
+    clear();
+
+    LOG_INFO_S << "updateMap: removed " << numTravNodes << " trav nodes and " << numObstNodes << " obstacle nodes";
+}
+
+EnvironmentXYZTheta::XYZNode* EnvironmentXYZTheta::getOrCreateXYZNode(traversability_generator3d::TravGenNode* travNode)
+{
+    std::atomic<XYZNode *> &entry(travNodeIdToXYZNode[travNode->getUserData().id]);
+    XYZNode *xyzNode = entry.load(std::memory_order_acquire);
+    if(xyzNode)
+        return xyzNode;
+
+    XYZNode *newNode = xyzNodeArena.create(travNode->getHeight(), travNode->getIndex());
+    newNode->getUserData().travNode = travNode;
+    newNode->getUserData().stateIds = stateTable.createBlock();
+    if(entry.compare_exchange_strong(xyzNode, newNode, std::memory_order_acq_rel))
+        return newNode;
+
+    //another thread was faster, xyzNode has been updated to its node.
+    //newNode and its id block stay unused until the next clear()
     return xyzNode;
 }
 
@@ -146,14 +267,15 @@ EnvironmentXYZTheta::ThetaNode* EnvironmentXYZTheta::createNewStateFromPose(cons
         travNode->setNotExpanded();
     }
 
-    XYZNode *xyzNode = createNewXYZState(travNode);
-
-    DiscreteTheta thetaD(theta, numAngles);
+    reserveStates(1);
+    const int stateId = getOrCreateState(travNode, DiscreteTheta(theta, numAngles));
+    publishStates();
 
+    const Hash &hash(idToHash[stateId]);
     if(xyzBackNode)
-        *xyzBackNode = xyzNode;
+        *xyzBackNode = hash.node;
 
-    return createNewState(thetaD, xyzNode);
+    return hash.thetaNode;
 }
 
 bool EnvironmentXYZTheta::obstacleCheck(const maps::grid::Vector3d& pos, double theta,
@@ -237,7 +359,7 @@ bool EnvironmentXYZTheta::checkStartGoalNode(const string& name, traversability_
 }
 
 
-void EnvironmentXYZTheta::setGoal(const Eigen::Vector3d& goalPos, double theta)
+void EnvironmentXYZTheta::setGoal(const Eigen::Vector3d& goalPos, double theta, bool computeHeuristic)
 {
 
 #ifdef ENABLE_DEBUG_DRAWINGS
@@ -282,17 +404,46 @@ void EnvironmentXYZTheta::setGoal(const Eigen::Vector3d& goalPos, double theta)
         throw ObstacleCheckFailed("goal position is invalid");
     }
 
-    try {
-        precomputeCost();
-        LOG_INFO_S << "Heuristic computed";
+    if(!computeHeuristic)
+    {
+        //Candidates are only rejected by the start field if it is needed anyway (backward search,
+        //goal estimates). Otherwise precomputeCost() checks the reachability of the accepted goal
+        //with the goal field, which is needed for the search anyway.
+        if(startHeuristicRequired)
+            precomputeStartCost();
+        if(startCostValid && !isReachableFromStart(goalXYZNode->getUserData().travNode))
+        {
+            LOG_INFO_S << "goal is not reachable from start";
+            throw std::runtime_error("goal is not reachable from start");
+        }
+        return;
     }
-    catch(const std::runtime_error& ex){
-        throw ex;
+
+    precomputeCost();
+    LOG_INFO_S << "Heuristic computed";
+}
+
+void EnvironmentXYZTheta::precomputeCost()
+{
+    //The start field is only needed by backward searches, otherwise it is computed on demand.
+    if(startHeuristicRequired)
+        precomputeStartCost();
+    precomputeGoalCost();
+
+    //with the lazy heuristic this only searches until the start is settled
+    if(getGoalDistance(startXYZNode->getUserData().travNode) >= maxDist)
+    {
+        LOG_INFO_S << "goal is not reachable from start";
+        throw std::runtime_error("goal is not reachable from start");
     }
+
     //draw greedy path
 #ifdef ENABLE_DEBUG_DRAWINGS
     V3DD::COMPLEX_DRAWING([&]()
     {
+        //the greedy path would expand the whole lazy search
+        if(lazyHeuristic)
+            return;
         V3DD::CLEAR_DRAWING("ugv_nav4d_greedyPath");
         traversability_generator3d::TravGenNode* nextNode = startXYZNode->getUserData().travNode;
         traversability_generator3d::TravGenNode* goal = goalXYZNode->getUserData().travNode;
@@ -307,7 +458,7 @@ void EnvironmentXYZTheta::setGoal(const Eigen::Vector3d& goalPos, double theta)
             for(maps::grid::TraversabilityNodeBase* node : nextNode->getConnections())
             {
                 traversability_generator3d::TravGenNode* travNode = static_cast<traversability_generator3d::TravGenNode*>(node);
-                const double cost = travNodeIdToDistance[travNode->getUserData().id].distToGoal;
+                const double cost = travNodeIdToDistance.distToGoal[travNode->getUserData().id];
                 if(cost < minCost)
                 {
                     minCost = cost;
@@ -326,6 +477,12 @@ void EnvironmentXYZTheta::setGoal(const Eigen::Vector3d& goalPos, double theta)
 
 void EnvironmentXYZTheta::expandMap(const std::vector<Eigen::Vector3d>& positions)
 {
+    if(expandedGeneration == mapGeneration && isExpanded(positions))
+    {
+        LOG_INFO_S << "expandMap: map unchanged and all positions covered, skipping expansion";
+        return;
+    }
+
 #ifdef ENABLE_DEBUG_DRAWINGS
     V3DD::COMPLEX_DRAWING([&]()
     {
@@ -340,6 +497,38 @@ void EnvironmentXYZTheta::expandMap(const std::vector<Eigen::Vector3d>& position
 
     travGen.expandAll(positions);
     obsGen.expandAll(positions);
+    //nodes reset by a region update are expanded with their own generator. Otherwise the search
+    //would expand the obstacle nodes with the trav generator and the distance layer would miss them
+    travGen.expandResetNodes();
+    obsGen.expandResetNodes();
+    obsGen.updateDistanceLayer();
+    //new nodes turn frontiers of the checked footprints into known patches
+    clearMotionChecks();
+    reserveMotionChecks();
+    expandedGeneration = mapGeneration;
+    //the new nodes are not part of the goal heuristic and the successors of the kept states
+    searchGraphOutdated = true;
+}
+
+size_t EnvironmentXYZTheta::getMapGeneration() const
+{
+    return mapGeneration;
+}
+
+bool EnvironmentXYZTheta::isExpanded(const std::vector<Eigen::Vector3d>& positions)
+{
+    for(const Eigen::Vector3d& pos : positions)
+    {
+        maps::grid::Index idxTravNode, idxObstNode;
+        if(!travGen.getTraversabilityMap().toGrid(pos, idxTravNode) || !obsGen.getTraversabilityMap().toGrid(pos, idxObstNode))
+            return false;
+
+        const traversability_generator3d::TravGenNode* travNode = travGen.findMatchingTraversabilityPatchAt(idxTravNode, pos.z());
+        const traversability_generator3d::TravGenNode* obstacleNode = obsGen.findMatchingTraversabilityPatchAt(idxObstNode, pos.z());
+        if(!travNode || !travNode->isExpanded() || !obstacleNode || !obstacleNode->isExpanded())
+            return false;
+    }
+    return true;
 }
 
 
@@ -353,6 +542,7 @@ void EnvironmentXYZTheta::setStart(const Eigen::Vector3d& startPos, double theta
 
     LOG_INFO_S << "START IS: " << startPos.transpose();
 
+    startCostValid = false;
     startThetaNode = createNewStateFromPose("start", startPos, theta, &startXYZNode);
     if(!startThetaNode)
         throw StateCreationFailed("Failed to create start state");
@@ -402,33 +592,61 @@ maps::grid::Vector3d EnvironmentXYZTheta::getStatePosition(const int stateID) co
     return ret;
 }
 
-const Motion& EnvironmentXYZTheta::getMotion(const int fromStateID, const int toStateID)
+std::pair<size_t, int> EnvironmentXYZTheta::getStateKey(const int stateID) const
 {
-    int cost = -1;
-    size_t motionId = 0;
-
-    vector<int> successStates;
-    vector<int> successStateCosts;
-    vector<size_t> motionIds;
-
-    GetSuccs(fromStateID, &successStates, &successStateCosts, motionIds);
+    const Hash &hash(idToHash[stateID]);
+    return std::make_pair(hash.node->getUserData().travNode->getUserData().id, hash.thetaNode->theta.getTheta());
+}
 
-    for(size_t i = 0; i < successStates.size(); i++)
+EnvironmentXYZTheta::SuccessorCandidate EnvironmentXYZTheta::getConnection(const int fromStateID, const int toStateID)
+{
+    const Hash &fromHash(idToHash[fromStateID]);
+    const Hash &toHash(idToHash[toStateID]);
+    traversability_generator3d::TravGenNode *fromTravNode = fromHash.node->getUserData().travNode;
+    const maps::grid::Index offset(toHash.node->getIndex() - fromHash.node->getIndex());
+
+    SuccessorCandidate best;
+    best.motion = nullptr;
+    if(checkExpandTreadSafe(fromTravNode))
     {
-        if(successStates[i] == toStateID)
+        traversability_generator3d::TravGenNode *fromObstacleNode = findObstacleNode(fromTravNode);
+        const auto& motions = availableMotions.getMotionForStartTheta(fromHash.thetaNode->theta);
+        std::atomic<float> *motionChecks = getMotionChecks(fromObstacleNode, fromHash.thetaNode->theta, motions.size());
+        SuccessorCandidate candidate;
+        for(size_t i = 0; i < motions.size(); ++i)
         {
-            if(cost == -1 || cost > successStateCosts[i])
+            //only the motions that end at the target state can connect the states
+            const Motion &motion(motions[i]);
+            if(motion.xDiff != offset.x() || motion.yDiff != offset.y() || !(motion.endTheta == toHash.thetaNode->theta))
+                continue;
+
+            if(getSuccessor(fromHash, fromObstacleNode, motion, motionChecks ? &motionChecks[i] : nullptr, candidate) &&
+               candidate.travNode == toHash.node->getUserData().travNode && (!best.motion || candidate.cost < best.cost))
             {
-                cost = successStateCosts[i];
-                motionId = motionIds[i];
+                best = candidate;
             }
         }
     }
 
-    if(cost == -1)
+    if(!best.motion)
         throw std::runtime_error("Internal Error: No matching motion for output path found");
 
-    return availableMotions.getMotion(motionId);
+    return best;
+}
+
+const Motion& EnvironmentXYZTheta::getMotion(const int fromStateID, const int toStateID)
+{
+    return *getConnection(fromStateID, toStateID).motion;
+}
+
+int EnvironmentXYZTheta::getPathCost(const std::vector<int>& stateIDPath)
+{
+    int cost = 0;
+    for(size_t i = 1; i < stateIDPath.size(); ++i)
+    {
+        cost += getConnection(stateIDPath[i - 1], stateIDPath[i]).cost;
+    }
+    return cost;
 }
 
 
@@ -456,7 +674,7 @@ int EnvironmentXYZTheta::GetGoalHeuristic(int stateID)
         return std::numeric_limits<int>::max();
     }
 
-    const double sourceToGoalDist = travNodeIdToDistance[travNode->getUserData().id].distToGoal;
+    const double sourceToGoalDist = getGoalDistance(travNode);
     const double timeTranslation = sourceToGoalDist / mobilityConfig.translationSpeed;
 
     //for point turns the translational time is zero, however turning still takes time
@@ -488,17 +706,46 @@ int EnvironmentXYZTheta::GetGoalHeuristic(int stateID)
 }
 
 void EnvironmentXYZTheta::enablePathStatistics(bool enable){
+    //the path statistics change the successors and their costs
+    if(enable != usePathStatistics)
+    {
+        searchGraphOutdated = true;
+        clearMotionChecks();
+    }
     usePathStatistics = enable;
 }
 
+void EnvironmentXYZTheta::setParallelHeuristic(bool enable, double bucketWidth)
+{
+    parallelHeuristic = enable;
+    deltaSteppingBucketWidth = bucketWidth;
+}
+
+void EnvironmentXYZTheta::enableLazyHeuristic(bool enable)
+{
+    //the goal distances are stored in a different place in lazy mode
+    if(enable != lazyHeuristic)
+        goalCostNode = nullptr;
+    lazyHeuristic = enable;
+}
+
+void EnvironmentXYZTheta::setStartHeuristicRequired(bool required)
+{
+    startHeuristicRequired = required;
+}
+
 int EnvironmentXYZTheta::GetStartHeuristic(int stateID)
 {
+    //memoized, only computed on the first call for the current start
+    precomputeStartCost();
+
     const Hash &targetHash(idToHash[stateID]);
     const XYZNode *targetNode = targetHash.node;
     const traversability_generator3d::TravGenNode* travNode = targetNode->getUserData().travNode;
     const ThetaNode *targetThetaNode = targetHash.thetaNode;
 
-    const double startToTargetDist = travNodeIdToDistance[travNode->getUserData().id].distToStart;
+    const size_t travNodeId = travNode->getUserData().id;
+    const double startToTargetDist = travNodeId < travNodeIdToDistance.distToStart.size() ? travNodeIdToDistance.distToStart[travNodeId] : maxDist;
     const double timeTranslation = startToTargetDist / mobilityConfig.translationSpeed;
     double timeRotation = startThetaNode->theta.shortestDist(targetThetaNode->theta).getRadian() / mobilityConfig.rotationSpeed;
 
@@ -524,25 +771,49 @@ bool EnvironmentXYZTheta::InitializeMDPCfg(MDPConfig* MDPCfg)
     return true;
 }
 
-EnvironmentXYZTheta::ThetaNode *EnvironmentXYZTheta::createNewState(const DiscreteTheta &curTheta, XYZNode *curNode)
+void EnvironmentXYZTheta::reserveStates(size_t numNewStates)
 {
-    ThetaNode *newNode = new ThetaNode(curTheta);
-    newNode->id = idToHash.size();
-    Hash hash(curNode, newNode);
-    idToHash.push_back(hash);
-    curNode->getUserData().thetaToNodes.insert(make_pair(curTheta, newNode));
+    const size_t numStates = stateTable.size() + numNewStates;
+    const size_t numTravNodes = travGen.getNumNodes();
+    //every new state creates at most one XYZNode and its id block
+    xyzNodeArena.reserve(xyzNodeArena.size() + numNewStates);
+    stateTable.reserve(stateTable.getNumBlocks() + numNewStates);
+    thetaNodeArena.reserve(numStates);
+    if(idToHash.size() < numStates)
+    {
+        idToHash.resize(std::max(numStates, 2 * idToHash.size()));
+    }
 
-    //this structure need to be extended for every new state that is added.
-    //Is seems it is later on filled in by the planner.
+    growAtomicVector<XYZNode *>(travNodeIdToXYZNode, numTravNodes, nullptr);
 
-    //insert into and initialize the mappings
-    int* entry = new int[NUMOFINDICES_STATEID2IND];
-    StateID2IndexMapping.push_back(entry);
-    for (int i = 0; i < NUMOFINDICES_STATEID2IND; i++) {
-        StateID2IndexMapping[newNode->id][i] = -1;
-    }
+    //storage of publishStates()
+    stateIndexRowArena.reserve(numStates);
+    if(StateID2IndexMapping.capacity() < numStates)
+        StateID2IndexMapping.reserve(std::max(numStates, 2 * StateID2IndexMapping.capacity()));
+}
 
-    return newNode;
+int EnvironmentXYZTheta::getOrCreateState(traversability_generator3d::TravGenNode* travNode, const DiscreteTheta& theta)
+{
+    XYZNode *xyzNode = getOrCreateXYZNode(travNode);
+    return stateTable.findOrInsert(xyzNode->getUserData().stateIds, theta.getTheta(), [&](int id)
+    {
+        ThetaNode *thetaNode = thetaNodeArena.create(theta);
+        thetaNode->id = id;
+        idToHash[id] = Hash(xyzNode, thetaNode);
+    });
+}
+
+void EnvironmentXYZTheta::publishStates()
+{
+    //sbpl needs one entry for every state. It is filled in by the planner.
+    const size_t numStates = stateTable.size();
+    stateIndexRowArena.reserve(numStates);
+    while(StateID2IndexMapping.size() < numStates)
+    {
+        std::array<int, NUMOFINDICES_STATEID2IND> *entry = stateIndexRowArena.create();
+        entry->fill(-1);
+        StateID2IndexMapping.push_back(entry->data());
+    }
 }
 
 traversability_generator3d::TravGenNode *EnvironmentXYZTheta::movementPossible(traversability_generator3d::TravGenNode *fromTravNode, const maps::grid::Index &fromIdx, const maps::grid::Index &toIdx)
@@ -596,7 +867,8 @@ bool EnvironmentXYZTheta::checkExpandTreadSafe(traversability_generator3d::TravG
 
 void EnvironmentXYZTheta::GetSuccs(int SourceStateID, vector< int >* SuccIDV, vector< int >* CostV)
 {
-    std::vector<size_t> motionId;
+    //reused between calls to avoid an allocation per expansion
+    static thread_local std::vector<size_t> motionId;
     GetSuccs(SourceStateID, SuccIDV, CostV, motionId);
 }
 
@@ -628,6 +900,28 @@ void EnvironmentXYZTheta::GetSuccs(int SourceStateID, vector< int >* SuccIDV, ve
     SuccIDV->clear();
     CostV->clear();
     motionIdV.clear();
+
+    std::vector<SuccessorCandidate> &candidates(successorScratch.candidates);
+    getSuccessorCandidates(SourceStateID, candidates);
+    reserveStates(candidates.size());
+
+    for(const SuccessorCandidate &candidate : candidates)
+    {
+        if(candidate.travNode->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
+        {
+            throw std::runtime_error("In GetSuccs() returned id for non-traversable patch");
+        }
+
+        SuccIDV->push_back(getOrCreateState(candidate.travNode, candidate.motion->endTheta));
+        CostV->push_back(candidate.cost);
+        motionIdV.push_back(candidate.motion->id);
+    }
+    publishStates();
+}
+
+void EnvironmentXYZTheta::getSuccessorCandidates(int SourceStateID, std::vector<SuccessorCandidate>& candidates)
+{
+    candidates.clear();
     const Hash &sourceHash(idToHash[SourceStateID]);
     const XYZNode *const sourceNode = sourceHash.node;
     const ThetaNode *const sourceThetaNode = sourceHash.thetaNode;
@@ -649,7 +943,7 @@ void EnvironmentXYZTheta::GetSuccs(int SourceStateID, vector< int >* SuccIDV, ve
 
     if(!sourceTravNode->isExpanded())
     {
-        if(!travGen.expandNode(sourceTravNode))
+        if(!checkExpandTreadSafe(sourceTravNode))
         {
             //expansion failed, current node is not driveable -> there are not successors to this state
             LOG_INFO_S<< "GetSuccs: current node not expanded and not expandable";
@@ -657,229 +951,289 @@ void EnvironmentXYZTheta::GetSuccs(int SourceStateID, vector< int >* SuccIDV, ve
         }
     }
 
-    Eigen::Vector3d sourcePosWorld;
-    travGen.getTraversabilityMap().fromGrid(sourceNode->getIndex(), sourcePosWorld, sourceTravNode->getHeight(), false);
-
     traversability_generator3d::TravGenNode *sourceObstacleNode = findObstacleNode(sourceTravNode);
     assert(sourceObstacleNode);
 
     const auto& motions = availableMotions.getMotionForStartTheta(sourceThetaNode->theta);
+    std::atomic<float> *motionChecks = getMotionChecks(sourceObstacleNode, sourceThetaNode->theta, motions.size());
 
-    //dynamic scheduling is choosen because the iterations have vastly different runtime
-    //due to the different sanity checks
-    //the chunk size (5) was chosen to reduce dynamic scheduling overhead.
-    //**No** tests have been done to verify whether 5 is a good value or not!
-    //#pragma omp parallel for schedule(dynamic, 5)
-    #pragma omp parallel for schedule(auto)
+    //NOTE this loop is intentionally single-threaded. Parallelism happens on the search level
+    //     (see ParallelSearch), forking threads for every expansion does not scale.
+    SuccessorCandidate candidate;
     for(size_t i = 0; i < motions.size(); ++i)
     {
-        //check that the motion is traversable (without collision checks) and find the goal node of the motion
-        const ugv_nav4d::Motion &motion(motions[i]);
-        traversability_generator3d::TravGenNode *goalTravNode = checkTraversableHeuristic(sourceNode->getIndex(), sourceNode->getUserData().travNode, motions[i], travGen.getTraversabilityMap());
-        if(!goalTravNode)
-        {
-            //at least one node on the path is not traversable
-            continue;
-        }
+        if(getSuccessor(sourceHash, sourceObstacleNode, motions[i], motionChecks ? &motionChecks[i] : nullptr, candidate))
+            candidates.push_back(candidate);
+    }
+}
 
-        //check motion path on obstacle map
-        std::vector<const traversability_generator3d::TravGenNode*> nodesOnObstPath;
-        std::vector<base::Pose2D> posesOnObstPath;
-        maps::grid::Index curObstIdx = sourceObstacleNode->getIndex();
-        traversability_generator3d::TravGenNode *obstNode = sourceObstacleNode;
-        bool intermediateStepsOk = true;
-        for(const PoseWithCell &diff : motion.intermediateStepsObstMap)
-        {
-            //diff is always a full offset to the start position
-            const maps::grid::Index newIndex =  sourceObstacleNode->getIndex() + diff.cell;
-            obstNode = movementPossible(obstNode, curObstIdx, newIndex);
-            nodesOnObstPath.push_back(obstNode);
-            base::Pose2D curPose = diff.pose;
-            curPose.position += sourcePosWorld.head<2>();
-            posesOnObstPath.push_back(curPose);
-            if(!obstNode)
-            {
-                intermediateStepsOk = false;
-                break;
-            }
+bool EnvironmentXYZTheta::getSuccessor(const Hash& source, traversability_generator3d::TravGenNode* sourceObstacleNode,
+                                       const Motion& motion, std::atomic<float>* motionCheck, SuccessorCandidate& candidate)
+{
+    const XYZNode *const sourceNode = source.node;
+    traversability_generator3d::TravGenNode *sourceTravNode = sourceNode->getUserData().travNode;
 
-            if(travConf.enableInclineLimitting)
-            {
-                if(!checkOrientationAllowed(obstNode, diff.pose.orientation))
-                {
-                    intermediateStepsOk = false;
-                    break;
-                }
-            }
-            curObstIdx = newIndex;
-        }
+    //check that the motion is traversable (without collision checks) and find the goal node of the motion
+    traversability_generator3d::TravGenNode *goalTravNode = checkTraversableHeuristic(sourceNode->getIndex(), sourceTravNode, motion, travGen.getTraversabilityMap());
+    if(!goalTravNode)
+    {
+        //at least one node on the path is not traversable
+        return false;
+    }
 
-        //no way from start to end on obstacle map
-        if(!intermediateStepsOk)
-            continue;
+    //the obstacle map checks only depend on the obstacle node and the motion,
+    //thus they are done once per map
+    float costFactor = motionCheck ? motionCheck->load(std::memory_order_relaxed) : 0;
+    if(costFactor == 0)
+    {
+        costFactor = checkMotionOnObstacleMap(sourceObstacleNode, sourceTravNode, motion);
+        if(motionCheck)
+            motionCheck->store(costFactor, std::memory_order_relaxed);
+    }
 
-        if (usePathStatistics){
-            PathStatistic statistic(travConf);
+    //no way from start to end on obstacle map
+    if(costFactor < 0)
+        return false;
 
-            if(!statistic.isPathFeasible(nodesOnObstPath, posesOnObstPath, getObstacleMap()))
-            {
-                continue;
-            }
-        }
+    double cost = motion.baseCost;
+    if(travConf.slopeMetric == traversability_generator3d::SlopeMetric::TRIANGLE_SLOPE)
+    {
+        //assume that the motion is a straight line, extrapolate into third dimension
+        //by projecting onto a plane that connects start and end cell.
+        const double heightDiff = std::abs(sourceNode->getHeight() - goalTravNode->getHeight());
+        //not perfect but probably more exact than the slope factors (see checkMotionOnObstacleMap())
+        const double approxMotionLen3D = std::sqrt(std::pow(motion.translationlDist, 2) + std::pow(heightDiff, 2));
+        assert(approxMotionLen3D >= motion.translationlDist);//due to triangle inequality
+        const double translationalVelocity = mobilityConfig.translationSpeed;
+        cost = Motion::calculateCost(approxMotionLen3D, motion.angularDist, translationalVelocity,
+                                     mobilityConfig.rotationSpeed, motion.costMultiplier);
+    }
+    cost *= costFactor;
 
-        //goal from source to the end of the motion was valid
-        XYZNode *successXYNode = nullptr;
-        ThetaNode *successthetaNode = nullptr;
+    oassert(cost <= std::numeric_limits<int>::max() && cost >= std::numeric_limits< int >::min());
+    oassert(int(cost) >= motion.baseCost);
+    oassert(motion.baseCost > 0);
 
-        //WARNING This becomes a critical section if several motion primitives
-        //        share the same finalPos.
-        //        As long as this is not the case this section should be save.
-        const maps::grid::Index finalPos(sourceNode->getIndex() + maps::grid::Index(motion.xDiff,motion.yDiff));
+    candidate.travNode = goalTravNode;
+    candidate.motion = &motion;
+    candidate.cost = (int)cost;
+    return true;
+}
 
-        #pragma omp critical(searchGridAccess)
-        {
-            const auto &candidateMap = searchGrid.at(finalPos);
+float EnvironmentXYZTheta::checkMotionOnObstacleMap(traversability_generator3d::TravGenNode* sourceObstacleNode,
+                                                    const traversability_generator3d::TravGenNode* sourceTravNode,
+                                                    const Motion& motion)
+{
+    //check motion path on obstacle map
+    std::vector<const traversability_generator3d::TravGenNode*> &nodesOnObstPath(successorScratch.nodesOnObstPath);
+    nodesOnObstPath.clear();
+    maps::grid::Index curObstIdx = sourceObstacleNode->getIndex();
+    traversability_generator3d::TravGenNode *obstNode = sourceObstacleNode;
+    for(const PoseWithCell &diff : motion.intermediateStepsObstMap)
+    {
+        //diff is always a full offset to the start position
+        const maps::grid::Index newIndex =  sourceObstacleNode->getIndex() + diff.cell;
+        obstNode = movementPossible(obstNode, curObstIdx, newIndex);
+        if(!obstNode)
+            return -1;
+        nodesOnObstPath.push_back(obstNode);
 
-            if(goalTravNode->getIndex() != finalPos)
-                throw std::runtime_error("Internal error, indexes do not match");
+        if(travConf.enableInclineLimitting)
+        {
+            if(!checkOrientationAllowed(obstNode, diff.pose.orientation))
+                return -1;
+        }
+        curObstIdx = newIndex;
+    }
 
-            XYZNode searchTmp(goalTravNode->getHeight(), goalTravNode->getIndex());
+    //Feasibility and clearance are evaluated in one walk over the footprint of the motion.
+    //The footprint only needs to be walked if an obstacle or frontier is close enough to
+    //touch the robot or the cost corridor around it.
+    PathStatistic statistic(travConf);
+    if (usePathStatistics && !isClearOfObstacles(nodesOnObstPath, travConf.costFunctionDist)){
+        statistic.calculateStatistics(sourceObstacleNode, availableMotions.getFootprint(motion.id), getObstacleMap());
 
-            //this works, as the equals check is on the height, not the node itself
-            auto it = candidateMap.find(&searchTmp);
+        if(statistic.getRobotStats().getNumObstacles() || statistic.getRobotStats().getNumFrontiers())
+            return -1;
+    }
 
-            if(it != candidateMap.end())
+    double costFactor = 1;
+    switch(travConf.slopeMetric)
+    {
+        case traversability_generator3d::SlopeMetric::AVG_SLOPE:
+        {
+            double avgSlope = 0;
+            if(nodesOnObstPath.size() > 0)
             {
-                //found a node with a matching height
-                successXYNode = *it;
+                avgSlope = getAvgSlope(nodesOnObstPath);
             }
             else
             {
-                successXYNode = createNewXYZState(goalTravNode); //modifies searchGrid at travNode->getIndex()
+                //This happens on point turns as they have no intermediate steps
+                avgSlope = sourceTravNode->getUserData().slope;
             }
+            const double slopeFactor = avgSlope * travConf.slopeMetricScale;
+            costFactor = 1 + slopeFactor;
+            LOG_INFO_S<< "baseCost: " << motion.baseCost << ", slopeFactor: " << slopeFactor;
+            break;
         }
-
-        #pragma omp critical(thetaToNodesAccess)
+        case traversability_generator3d::SlopeMetric::MAX_SLOPE:
         {
-            const auto &thetaMap(successXYNode->getUserData().thetaToNodes);
-
-            auto thetaCandidate = thetaMap.find(motion.endTheta);
-            if(thetaCandidate != thetaMap.end())
+            double maxSlope = 0;
+            if(nodesOnObstPath.size() > 0)
             {
-                successthetaNode = thetaCandidate->second;
+                maxSlope = getMaxSlope(nodesOnObstPath);
             }
             else
             {
-                successthetaNode = createNewState(motion.endTheta, successXYNode);
+                //This happens on point turns as they have no intermediate steps
+                maxSlope = sourceTravNode->getUserData().slope;
             }
+            const double slopeFactor = maxSlope * travConf.slopeMetricScale;
+            costFactor = 1 + slopeFactor;
+            break;
         }
+        case traversability_generator3d::SlopeMetric::TRIANGLE_SLOPE:
+            //computed on the trav map, see getSuccessorCandidates()
+        case traversability_generator3d::SlopeMetric::NONE:
+            break;
+        default:
+            throw std::runtime_error("unknown slope metric selected");
+    }
 
-        double cost = 0;
-        switch(travConf.slopeMetric)
+    //the statistics are empty if the path is clear of obstacles
+    if (usePathStatistics){
+        if(statistic.getBoundaryStats().getNumObstacles())
         {
-            case traversability_generator3d::SlopeMetric::AVG_SLOPE:
-            {
-                double avgSlope = 0;
-                if(nodesOnObstPath.size() > 0)
-                {
-                    avgSlope = getAvgSlope(nodesOnObstPath);
-                }
-                else
-                {
-                    //This happens on point turns as they have no intermediate steps
-                    avgSlope = sourceTravNode->getUserData().slope;
-                }
-                const double slopeFactor = avgSlope * travConf.slopeMetricScale;
-                cost = motion.baseCost + motion.baseCost * slopeFactor;
-                LOG_INFO_S<< "cost: " << cost << ", baseCost: " << motion.baseCost << ", slopeFactor: " << slopeFactor;
-                break;
-            }
-            case traversability_generator3d::SlopeMetric::MAX_SLOPE:
-            {
-                double maxSlope = 0;
-                if(nodesOnObstPath.size() > 0)
-                {
-                    maxSlope = getMaxSlope(nodesOnObstPath);
-                }
-                else
-                {
-                    //This happens on point turns as they have no intermediate steps
-                    maxSlope = sourceTravNode->getUserData().slope;
-                }
-                const double slopeFactor = maxSlope * travConf.slopeMetricScale;
-                cost = motion.baseCost + motion.baseCost * slopeFactor;
-                break;
-            }
-            case traversability_generator3d::SlopeMetric::TRIANGLE_SLOPE:
-            {
-                //assume that the motion is a straight line, extrapolate into third dimension
-                //by projecting onto a plane that connects start and end cell.
-                const double heightDiff = std::abs(sourceNode->getHeight() - successXYNode->getHeight());
-                //not perfect but probably more exact than the slope factors above
-                const double approxMotionLen3D = std::sqrt(std::pow(motion.translationlDist, 2) + std::pow(heightDiff, 2));
-                assert(approxMotionLen3D >= motion.translationlDist);//due to triangle inequality
-                const double translationalVelocity = mobilityConfig.translationSpeed;
-                cost = Motion::calculateCost(approxMotionLen3D, motion.angularDist, translationalVelocity,
-                                             mobilityConfig.rotationSpeed, motion.costMultiplier);
-                break;
-            }
-            case traversability_generator3d::SlopeMetric::NONE:
-                cost = motion.baseCost;
-                break;
-            default:
-                throw std::runtime_error("unknown slope metric selected");
+            const double outer_radius = travConf.costFunctionDist;
+            double minDistToRobot = statistic.getBoundaryStats().getMinDistToObstacles();
+            minDistToRobot = std::min(outer_radius, minDistToRobot);
+            double impactFactor = (outer_radius - minDistToRobot) / outer_radius;
+            oassert(impactFactor < 1.001 && impactFactor >= 0);
+
+            costFactor += costFactor * impactFactor;
         }
 
-        if (usePathStatistics){
-            PathStatistic statistic(travConf);
-            if(statistic.getBoundaryStats().getNumObstacles())
-            {
-                const double outer_radius = travConf.costFunctionDist;
-                double minDistToRobot = statistic.getBoundaryStats().getMinDistToObstacles();
-                minDistToRobot = std::min(outer_radius, minDistToRobot);
-                double impactFactor = (outer_radius - minDistToRobot) / outer_radius;
-                oassert(impactFactor < 1.001 && impactFactor >= 0);
+        if(statistic.getBoundaryStats().getNumFrontiers())
+        {
+            const double outer_radius = travConf.costFunctionDist;
+            double minDistToRobot = statistic.getBoundaryStats().getMinDistToFrontiers();
+            minDistToRobot = std::min(outer_radius, minDistToRobot);
+            double impactFactor = (outer_radius - minDistToRobot) / outer_radius;
+            oassert(impactFactor < 1.001 && impactFactor >= 0);
 
-                cost += cost * impactFactor;
-            }
+            costFactor += costFactor * impactFactor;
+        }
+    }
 
-            if(statistic.getBoundaryStats().getNumFrontiers())
-            {
-                const double outer_radius = travConf.costFunctionDist;
-                double minDistToRobot = statistic.getBoundaryStats().getMinDistToFrontiers();
-                minDistToRobot = std::min(outer_radius, minDistToRobot);
-                double impactFactor = (outer_radius - minDistToRobot) / outer_radius;
-                oassert(impactFactor < 1.001 && impactFactor >= 0);
+    //the factor is cached as float, the cost has to be the same with and without the cache
+    return static_cast<float>(costFactor);
+}
 
-                cost += cost * impactFactor;
-            }
-        }
+std::atomic<float>* EnvironmentXYZTheta::getMotionChecks(const traversability_generator3d::TravGenNode* obstacleNode,
+                                                         const DiscreteTheta& theta, size_t numMotions)
+{
+    const size_t nodeId = obstacleNode->getUserData().id;
+    if(nodeId >= obstNodeToMotionCheckBlock.size() || numMotions > motionCheckChunkSize)
+    {
+        //the node has been created during the search, it is not cached
+        return nullptr;
+    }
 
-        oassert(cost <= std::numeric_limits<int>::max() && cost >= std::numeric_limits< int >::min());
-        oassert(int(cost) >= motion.baseCost);
-        oassert(motion.baseCost > 0);
+    std::atomic<std::atomic<float>*> *block = nullptr;
+    std::atomic<float> *checks = nullptr;
+    uint64_t entry = obstNodeToMotionCheckBlock[nodeId].load(std::memory_order_acquire);
+    if((entry >> 32) == motionCheckGeneration)
+    {
+        const size_t blockIdx = (entry & 0xFFFFFFFF) - 1;
+        block = &motionCheckBlockChunks[blockIdx / motionCheckBlocksPerChunk][(blockIdx % motionCheckBlocksPerChunk) * numAngles];
+        checks = block[theta.getTheta()].load(std::memory_order_acquire);
+        if(checks)
+            return checks;
+    }
 
-        const int iCost = (int)cost;
-        #pragma omp critical(updateData)
+    #pragma omp critical(motionCheckAllocation)
+    {
+        entry = obstNodeToMotionCheckBlock[nodeId].load(std::memory_order_relaxed);
+        if((entry >> 32) != motionCheckGeneration)
         {
-            SuccIDV->push_back(successthetaNode->id);
-            CostV->push_back(iCost);
-            motionIdV.push_back(motion.id);
-
-            //####BEGIN DEBUG BLOCK!
-            {
-                const Hash &sourceHashh(idToHash[successthetaNode->id]);
-                const XYZNode *sourceNodeh = sourceHashh.node;
-                const traversability_generator3d::TravGenNode* travNodeh = sourceNodeh->getUserData().travNode;
+            //first visit of the node since the last clearMotionChecks()
+            const size_t blockIdx = motionCheckBlocksUsed++;
+            std::unique_ptr<std::atomic<std::atomic<float>*>[]> &chunk(motionCheckBlockChunks[blockIdx / motionCheckBlocksPerChunk]);
+            if(!chunk)
+                chunk.reset(new std::atomic<std::atomic<float>*>[motionCheckBlocksPerChunk * numAngles]);
+            block = &chunk[(blockIdx % motionCheckBlocksPerChunk) * numAngles];
+            for(int i = 0; i < numAngles; ++i)
+                block[i].store(nullptr, std::memory_order_relaxed);
+            obstNodeToMotionCheckBlock[nodeId].store((uint64_t(motionCheckGeneration) << 32) | (blockIdx + 1), std::memory_order_release);
+        }
+        else if(!block)
+        {
+            const size_t blockIdx = (entry & 0xFFFFFFFF) - 1;
+            block = &motionCheckBlockChunks[blockIdx / motionCheckBlocksPerChunk][(blockIdx % motionCheckBlocksPerChunk) * numAngles];
+        }
 
-                if(travNodeh->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
-                {
-                    throw std::runtime_error("In GetSuccs() returned id for non-traversable patch");
-                }
-            }
-            //####END DEBUG BLOCK!!!
+        checks = block[theta.getTheta()].load(std::memory_order_relaxed);
+        if(!checks)
+        {
+            //an entry must not span two chunks
+            if(motionChecksUsed % motionCheckChunkSize + numMotions > motionCheckChunkSize)
+                motionChecksUsed += motionCheckChunkSize - motionChecksUsed % motionCheckChunkSize;
+            const size_t chunk = motionChecksUsed / motionCheckChunkSize;
+            if(chunk == motionCheckChunks.size())
+                motionCheckChunks.emplace_back(new std::atomic<float>[motionCheckChunkSize]);
+            checks = motionCheckChunks[chunk].get() + motionChecksUsed % motionCheckChunkSize;
+            motionChecksUsed += numMotions;
+            for(size_t i = 0; i < numMotions; ++i)
+                checks[i].store(0, std::memory_order_relaxed);
+            block[theta.getTheta()].store(checks, std::memory_order_release);
         }
     }
+    return checks;
+}
+
+constexpr size_t EnvironmentXYZTheta::motionCheckChunkSize;
+constexpr size_t EnvironmentXYZTheta::motionCheckBlocksPerChunk;
+
+void EnvironmentXYZTheta::reserveMotionChecks()
+{
+    const size_t numNodes = obsGen.getNumNodes();
+    growAtomicVector<uint64_t>(obstNodeToMotionCheckBlock, numNodes, 0);
+    //the chunks themselves are allocated on first use
+    const size_t numChunks = (obstNodeToMotionCheckBlock.size() + motionCheckBlocksPerChunk - 1) / motionCheckBlocksPerChunk;
+    if(motionCheckBlockChunks.size() < numChunks)
+        motionCheckBlockChunks.resize(numChunks);
+}
+
+void EnvironmentXYZTheta::clearMotionChecks()
+{
+    //blocks of older generations are dropped on access, thus the entries do not need to be visited
+    if(++motionCheckGeneration == 0)
+    {
+        //the generation wrapped around, old entries could look valid again
+        for(std::atomic<uint64_t> &entry : obstNodeToMotionCheckBlock)
+            entry.store(0, std::memory_order_relaxed);
+        motionCheckGeneration = 1;
+    }
+    //the chunks are reused, the blocks and values are reset when they are handed out again
+    motionCheckBlocksUsed = 0;
+    motionChecksUsed = 0;
+}
+
+bool EnvironmentXYZTheta::isClearOfObstacles(const std::vector<const traversability_generator3d::TravGenNode*>& path, double corridor) const
+{
+    //the poses lie inside the cells of their nodes and a cell touches the robot if one of its corners does.
+    //The additional cell is a margin for the inaccuracy of the distance layer.
+    const double cellRadius = travConf.gridResolution * std::sqrt(0.5);
+    const double robotRadius = Eigen::Vector2d(travConf.robotSizeX / 2.0 + corridor, travConf.robotSizeY / 2.0 + corridor).norm();
+    const double touchDistance = robotRadius + 2 * cellRadius + travConf.gridResolution;
+
+    for(const traversability_generator3d::TravGenNode* node : path)
+    {
+        if(obsGen.getObstacleDistance(node) <= touchDistance || obsGen.getFrontierDistance(node) <= touchDistance)
+            return false;
+    }
+    return true;
 }
 
 bool EnvironmentXYZTheta::checkOrientationAllowed(const traversability_generator3d::TravGenNode* node,
@@ -910,7 +1264,7 @@ void EnvironmentXYZTheta::GetPreds(int TargetStateID, vector< int >* PredIDV, ve
 
 int EnvironmentXYZTheta::SizeofCreatedEnv()
 {
-    return static_cast<int>(idToHash.size());
+    return static_cast<int>(stateTable.size());
 }
 
 void EnvironmentXYZTheta::PrintEnv_Config(FILE* fOut)
@@ -950,26 +1304,42 @@ void EnvironmentXYZTheta::getTrajectory(const vector<int>& stateIDPath,
                                         vector<SubTrajectory>& result,
                                         bool setZToZero, const Eigen::Vector3d &startPos,
                                         const Eigen::Vector3d &goalPos, const double& goalHeading, const Eigen::Affine3d &plan2Body)
+{
+    if(setZToZero)
+        getTrajectories(stateIDPath, &result, nullptr, startPos, goalPos, goalHeading, plan2Body);
+    else
+        getTrajectories(stateIDPath, nullptr, &result, startPos, goalPos, goalHeading, plan2Body);
+}
+
+void EnvironmentXYZTheta::getTrajectories(const vector<int>& stateIDPath,
+                                          vector<SubTrajectory>* result2D, vector<SubTrajectory>* result3D,
+                                          const Eigen::Vector3d &startPos, const Eigen::Vector3d &goalPos,
+                                          const double& goalHeading, const Eigen::Affine3d &plan2Body)
 {
     if(stateIDPath.size() < 2)
         return;
 
-    result.clear();
-    base::Trajectory curPart;
+    std::vector<TrajectoryBuilder> builders;
+    if(result2D)
+        builders.emplace_back(result2D, true, startPos);
+    if(result3D)
+        builders.emplace_back(result3D, false, startPos);
+
+    for(TrajectoryBuilder &builder : builders)
+        builder.result->clear();
 
 #ifdef ENABLE_DEBUG_DRAWINGS
         V3DD::CLEAR_DRAWING("ugv_nav4d_trajectory");
 #endif
 
-    int indexOfMotionToUpdate{stateIDPath.size()-2};
+    size_t indexOfMotionToUpdate = stateIDPath.size()-2;
     const Motion& finalMotion = getMotion(stateIDPath[stateIDPath.size()-2], stateIDPath[stateIDPath.size()-1]);
     if (finalMotion.type == Motion::Type::MOV_POINTTURN && stateIDPath.size() > 2){ //assuming that there are no consecutive point turns motion at the end of a planned trajectory
         indexOfMotionToUpdate = stateIDPath.size()-3;
     }
 
-    bool goal_position_updated = false;
+    const Eigen::Affine3d body2Plan = plan2Body.inverse(Eigen::Isometry);
 
-    Eigen::Vector3d start = startPos;
     for(size_t i = 0; i < stateIDPath.size() - 1; ++i)
     {
         const Motion& curMotion = getMotion(stateIDPath[i], stateIDPath[i+1]);
@@ -977,8 +1347,11 @@ void EnvironmentXYZTheta::getTrajectory(const vector<int>& stateIDPath,
         const maps::grid::Index startIndex(startHash.node->getIndex());
         maps::grid::Index lastIndex = startIndex;
         traversability_generator3d::TravGenNode *curNode = startHash.node->getUserData().travNode;
-        std::vector<base::Vector3d> positions;
 
+        for(TrajectoryBuilder &builder : builders)
+            builder.positions.clear();
+
+        //the node lookups are shared by all trajectories
         for(const CellWithPoses &cwp : curMotion.fullSplineSamples)
         {
             maps::grid::Index curIndex = startIndex + cwp.cell;
@@ -997,153 +1370,165 @@ void EnvironmentXYZTheta::getTrajectory(const vector<int>& stateIDPath,
 
             for(const base::Pose2D &p : cwp.poses)
             {
-                //start is already corrected to be in the middle of a cell, thus cwp.pose.position should not be corrected
-                base::Vector3d pos(p.position.x() + start.x(), p.position.y() + start.y(), start.z());
-                pos.z() = curNode->getHeight();
-                // HACK this overwrite avoids wrong headings in trajectory
-                //See ticket: https://git.hb.dfki.de/entern/ugv_nav4d/issues/1
-                if(setZToZero)
-                    pos.z() = 0.0;
-                //this just changes the z-coordinate (slightly wasteful to use Affine3d for that, but not inside critical loop)
-                Eigen::Vector3d pos_Body = plan2Body.inverse(Eigen::Isometry) * pos;
-                if(positions.empty() || !(positions.back().isApprox(pos_Body)))
+                for(TrajectoryBuilder &builder : builders)
                 {
-                    //need to offset by start because the poses are relative to (0/0)
-                    positions.emplace_back(pos_Body);
+                    //start is already corrected to be in the middle of a cell, thus cwp.pose.position should not be corrected
+                    base::Vector3d pos(p.position.x() + builder.start.x(), p.position.y() + builder.start.y(), curNode->getHeight());
+                    // HACK this overwrite avoids wrong headings in trajectory
+                    //See ticket: https://git.hb.dfki.de/entern/ugv_nav4d/issues/1
+                    if(builder.setZToZero)
+                        pos.z() = 0.0;
+                    //this just changes the z-coordinate
+                    const Eigen::Vector3d pos_Body = body2Plan * pos;
+                    if(builder.positions.empty() || !(builder.positions.back().isApprox(pos_Body)))
+                    {
+                        //need to offset by start because the poses are relative to (0/0)
+                        builder.positions.emplace_back(pos_Body);
+                    }
                 }
             }
         }
-        if (mobilityConfig.remove_goal_offset == true &&
-            i == indexOfMotionToUpdate)
+
+        for(TrajectoryBuilder &builder : builders)
         {
-            LOG_INFO_S << "Original spline end position: " << positions[positions.size()-1];
-            double goal_offset_x = (goalPos.x() - positions[positions.size()-1].x()) / (positions.size()-1);
-            double goal_offset_y = (goalPos.y() - positions[positions.size()-1].y()) / (positions.size()-1);
+            std::vector<base::Vector3d> &positions(builder.positions);
+            base::Trajectory &curPart(builder.curPart);
 
-            for (int j{0}; j < positions.size(); j++){
-                positions[j].x() += j*goal_offset_x;
-                positions[j].y() += j*goal_offset_y;
+            if (mobilityConfig.remove_goal_offset == true &&
+                i == indexOfMotionToUpdate)
+            {
+                LOG_INFO_S << "Original spline end position: " << positions[positions.size()-1];
+                double goal_offset_x = (goalPos.x() - positions[positions.size()-1].x()) / (positions.size()-1);
+                double goal_offset_y = (goalPos.y() - positions[positions.size()-1].y()) / (positions.size()-1);
+
+                for (size_t j{0}; j < positions.size(); j++){
+                    positions[j].x() += j*goal_offset_x;
+                    positions[j].y() += j*goal_offset_y;
+                }
+                LOG_INFO_S << "Updated spline end position: " << positions[positions.size()-1];
+                builder.goalPositionUpdated = true;
             }
-            LOG_INFO_S << "Updated spline end position: " << positions[positions.size()-1];
-            goal_position_updated = true;
-        }
 
-        curPart.spline.interpolate(positions);
+            curPart.spline.interpolate(positions);
 
 #ifdef ENABLE_DEBUG_DRAWINGS
-            V3DD::COMPLEX_DRAWING([&]()
+            //only the last trajectory is drawn, drawing both would overlay them
+            if(&builder == &builders.back())
             {
-                Eigen::Vector4d color = V3DD::Color::cyan;
-                Eigen::Vector3d size(0.01, 0.01, 0.2);
-                switch(curMotion.type)
+                V3DD::COMPLEX_DRAWING([&]()
                 {
-                    case Motion::MOV_BACKWARD:
-                        color = V3DD::Color::magenta;
-                        break;
-                    case Motion::MOV_FORWARD:
-                        color = V3DD::Color::cyan;
-                        break;
-                    case Motion::MOV_POINTTURN:
-                        color = V3DD::Color::red;
-                        size.z() = 1;
-                        V3DD::DRAW_CYLINDER("ugv_nav4d_trajectory", getStatePosition(stateIDPath[i]),  size, color);
-                        break;
-                    case Motion::MOV_LATERAL:
-                        color = V3DD::Color::green;
-                        break;
-
-                    default:
-                        color =  V3DD::Color::red;
-                }
-                for(base::Vector3d pos : positions)
-                {
-    //                 pos = mlsGrid->getLocalFrame().inverse(Eigen::Isometry) * pos;
-                    V3DD::DRAW_CYLINDER("ugv_nav4d_trajectory", pos,  size, color);
-                }
-            });
+                    Eigen::Vector4d color = V3DD::Color::cyan;
+                    Eigen::Vector3d size(0.01, 0.01, 0.2);
+                    switch(curMotion.type)
+                    {
+                        case Motion::MOV_BACKWARD:
+                            color = V3DD::Color::magenta;
+                            break;
+                        case Motion::MOV_FORWARD:
+                            color = V3DD::Color::cyan;
+                            break;
+                        case Motion::MOV_POINTTURN:
+                            color = V3DD::Color::red;
+                            size.z() = 1;
+                            V3DD::DRAW_CYLINDER("ugv_nav4d_trajectory", getStatePosition(stateIDPath[i]),  size, color);
+                            break;
+                        case Motion::MOV_LATERAL:
+                            color = V3DD::Color::green;
+                            break;
+
+                        default:
+                            color =  V3DD::Color::red;
+                    }
+                    for(base::Vector3d pos : positions)
+                    {
+                        V3DD::DRAW_CYLINDER("ugv_nav4d_trajectory", pos,  size, color);
+                    }
+                });
+            }
 #endif
 
-        if (curMotion.type == Motion::Type::MOV_POINTTURN)
-        {
-            SubTrajectory subtraj;
-            subtraj.driveMode = DriveMode::ModeTurnOnTheSpot;
-
-            std::vector<base::Angle> angles;
-            angles.emplace_back(base::Angle::fromRad(curMotion.startTheta.getRadian()));
-            angles.emplace_back(base::Angle::fromRad(curMotion.endTheta.getRadian()));
-
-            base::Pose2D startPose;
-            startPose.position.x() = start.x();
-            startPose.position.y() = start.y();
-            startPose.orientation  = curMotion.startTheta.getRadian();
-
-            base::Pose2D goalPose;
-            goalPose.position.x() = start.x();
-            goalPose.position.y() = start.y();
-            goalPose.orientation  = curMotion.endTheta.getRadian();
-
-            subtraj.interpolate(startPose,angles);
-            subtraj.startPose     = startPose;
-            subtraj.goalPose      = goalPose;
-            result.push_back(subtraj);
-        }
-        else
-        {
-            if (curMotion.type == Motion::Type::MOV_BACKWARD)
+            if (curMotion.type == Motion::Type::MOV_POINTTURN)
             {
-                curPart.speed = -mobilityConfig.translationSpeed;
-            }
-            else
-            {
-                curPart.speed = mobilityConfig.translationSpeed;
-            }
-            SubTrajectory curPartSub(curPart);
-            switch (curMotion.type) {
-                case Motion::Type::MOV_FORWARD:
-                    curPartSub.driveMode = DriveMode::ModeAckermann;
-                    break;
-                case Motion::Type::MOV_BACKWARD:
-                    curPartSub.driveMode = DriveMode::ModeAckermann;
-                    break;
-                case Motion::Type::MOV_LATERAL:
-                    curPartSub.driveMode = DriveMode::ModeSideways;
-                    break;
-            }
-            result.push_back(curPartSub);
-
-            if (goal_position_updated){
                 SubTrajectory subtraj;
                 subtraj.driveMode = DriveMode::ModeTurnOnTheSpot;
 
+                std::vector<base::Angle> angles;
+                angles.emplace_back(base::Angle::fromRad(curMotion.startTheta.getRadian()));
+                angles.emplace_back(base::Angle::fromRad(curMotion.endTheta.getRadian()));
+
                 base::Pose2D startPose;
-                startPose.position.x() = curPart.spline.getEndPoint().x();
-                startPose.position.y() = curPart.spline.getEndPoint().y();
-                startPose.orientation  = curPart.spline.getHeading(curPart.spline.getEndParam());
-                if (startPose.orientation < 0){
-                    startPose.orientation += 2*M_PI;
-                }
+                startPose.position.x() = builder.start.x();
+                startPose.position.y() = builder.start.y();
+                startPose.orientation  = curMotion.startTheta.getRadian();
 
                 base::Pose2D goalPose;
-                goalPose.position.x() = curPart.spline.getEndPoint().x();
-                goalPose.position.y() = curPart.spline.getEndPoint().y();
-                goalPose.orientation  = goalHeading;
-                if (goalPose.orientation < 0){
-                    goalPose.orientation += 2*M_PI;
+                goalPose.position.x() = builder.start.x();
+                goalPose.position.y() = builder.start.y();
+                goalPose.orientation  = curMotion.endTheta.getRadian();
+
+                subtraj.interpolate(startPose,angles);
+                subtraj.startPose     = startPose;
+                subtraj.goalPose      = goalPose;
+                builder.result->push_back(subtraj);
+            }
+            else
+            {
+                if (curMotion.type == Motion::Type::MOV_BACKWARD)
+                {
+                    curPart.speed = -mobilityConfig.translationSpeed;
+                }
+                else
+                {
+                    curPart.speed = mobilityConfig.translationSpeed;
                 }
-                
-                if (std::abs(goalPose.orientation - startPose.orientation) > 0.01){ //needed otherwise spline interpolation has an exception
-                    std::vector<base::Angle> angles;
-                    angles.emplace_back(base::Angle::fromRad(startPose.orientation));
-                    angles.emplace_back(base::Angle::fromRad(goalPose.orientation));
-
-                    subtraj.interpolate(goalPose,angles);
-                    subtraj.startPose     = startPose;
-                    subtraj.goalPose      = goalPose;
-                    result.push_back(subtraj);
+                SubTrajectory curPartSub(curPart);
+                switch (curMotion.type) {
+                    case Motion::Type::MOV_FORWARD:
+                        curPartSub.driveMode = DriveMode::ModeAckermann;
+                        break;
+                    case Motion::Type::MOV_BACKWARD:
+                        curPartSub.driveMode = DriveMode::ModeAckermann;
+                        break;
+                    case Motion::Type::MOV_LATERAL:
+                        curPartSub.driveMode = DriveMode::ModeSideways;
+                        break;
                 }
-                goal_position_updated = false;
+                builder.result->push_back(curPartSub);
+
+                if (builder.goalPositionUpdated){
+                    SubTrajectory subtraj;
+                    subtraj.driveMode = DriveMode::ModeTurnOnTheSpot;
+
+                    base::Pose2D startPose;
+                    startPose.position.x() = curPart.spline.getEndPoint().x();
+                    startPose.position.y() = curPart.spline.getEndPoint().y();
+                    startPose.orientation  = curPart.spline.getHeading(curPart.spline.getEndParam());
+                    if (startPose.orientation < 0){
+                        startPose.orientation += 2*M_PI;
+                    }
+
+                    base::Pose2D goalPose;
+                    goalPose.position.x() = curPart.spline.getEndPoint().x();
+                    goalPose.position.y() = curPart.spline.getEndPoint().y();
+                    goalPose.orientation  = goalHeading;
+                    if (goalPose.orientation < 0){
+                        goalPose.orientation += 2*M_PI;
+                    }
+
+                    if (std::abs(goalPose.orientation - startPose.orientation) > 0.01){ //needed otherwise spline interpolation has an exception
+                        std::vector<base::Angle> angles;
+                        angles.emplace_back(base::Angle::fromRad(startPose.orientation));
+                        angles.emplace_back(base::Angle::fromRad(goalPose.orientation));
+
+                        subtraj.interpolate(goalPose,angles);
+                        subtraj.startPose     = startPose;
+                        subtraj.goalPose      = goalPose;
+                        builder.result->push_back(subtraj);
+                    }
+                    builder.goalPositionUpdated = false;
+                }
+                builder.start = curPart.spline.getEndPoint();
             }
-            start = curPart.spline.getEndPoint();
         }
     }
 }
@@ -1168,7 +1553,7 @@ const PreComputedMotions& EnvironmentXYZTheta::getAvailableMotions() const
     return availableMotions;
 }
 
-double EnvironmentXYZTheta::getAvgSlope(std::vector<const traversability_generator3d::TravGenNode*> path) const
+double EnvironmentXYZTheta::getAvgSlope(const std::vector<const traversability_generator3d::TravGenNode*>& path) const
 {
     if(path.size() <= 0)
     {
@@ -1184,7 +1569,7 @@ double EnvironmentXYZTheta::getAvgSlope(std::vector<const traversability_generat
     return avgSlope;
 }
 
-double EnvironmentXYZTheta::getMaxSlope(std::vector<const traversability_generator3d::TravGenNode*> path) const
+double EnvironmentXYZTheta::getMaxSlope(const std::vector<const traversability_generator3d::TravGenNode*>& path) const
 {
     const traversability_generator3d::TravGenNode* maxElem =  *std::max_element(path.begin(), path.end(),
                                   [] (const traversability_generator3d::TravGenNode* lhs, const traversability_generator3d::TravGenNode* rhs)
@@ -1194,39 +1579,81 @@ double EnvironmentXYZTheta::getMaxSlope(std::vector<const traversability_generat
     return maxElem->getUserData().slope;
 }
 
-void EnvironmentXYZTheta::precomputeCost()
+void EnvironmentXYZTheta::precomputeStartCost()
 {
+    if(startCostValid)
+        return;
 
-    std::unordered_map<const maps::grid::TraversabilityNodeBase*, double> costToStart;
-    std::unordered_map<const maps::grid::TraversabilityNodeBase*, double> costToEnd;
+    computeDistanceField(startXYZNode->getUserData().travNode, travNodeIdToDistance.distToStart);
+    startCostValid = true;
+}
 
-    Dijkstra::computeCost(startXYZNode->getUserData().travNode, costToStart, travConf);
-    Dijkstra::computeCost(goalXYZNode->getUserData().travNode, costToEnd, travConf);
+void EnvironmentXYZTheta::precomputeGoalCost()
+{
+    //the distances only depend on the goal and on the map. They are still valid when replanning
+    //to the same goal, unless the map has been expanded in the meantime
+    const traversability_generator3d::TravGenNode* goalNode = goalXYZNode->getUserData().travNode;
+    if(goalNode == goalCostNode && travGen.getNumNodes() == goalCostNumNodes)
+        return;
 
-    if (costToStart.size() != costToEnd.size()){
-        throw std::runtime_error("costToStart.size() is not equal to costToEnd.size()");
+    if(lazyHeuristic)
+    {
+        travNodeIdToDistance.distToGoal.clear();
+        lazyGoalDistance.reset(goalNode, travGen.getNumNodes(), maxDist, travConf);
     }
+    else
+    {
+        computeDistanceField(goalNode, travNodeIdToDistance.distToGoal);
+    }
+    goalCostNode = goalNode;
+    goalCostNumNodes = travGen.getNumNodes();
+}
 
-    //FIXME this should be a config value?!
-    const double maxDist = 99999999; //big enough to never occur in reality. Small enough to not cause overflows when used by accident.
-    travNodeIdToDistance.clear();
-    travNodeIdToDistance.resize(travGen.getNumNodes(), Distance(maxDist, maxDist));
+double EnvironmentXYZTheta::getGoalDistance(const traversability_generator3d::TravGenNode* node)
+{
+    if(lazyHeuristic)
+        return lazyGoalDistance.getDistance(node);
+
+    const size_t travNodeId = node->getUserData().id;
+    //nodes that have been generated after the heuristic was computed are unreachable
+    return travNodeId < travNodeIdToDistance.distToGoal.size() ? travNodeIdToDistance.distToGoal[travNodeId] : maxDist;
+}
 
-    for(const auto pair : costToStart)
+void EnvironmentXYZTheta::computeDistanceField(const traversability_generator3d::TravGenNode* source, std::vector<double>& outDistances) const
+{
+    if(parallelHeuristic)
+    {
+        Dijkstra::computeCostParallel(source, outDistances, travGen.getNumNodes(), maxDist,
+                                      deltaSteppingBucketWidth, travConf);
+    }
+    else
     {
-        const traversability_generator3d::TravGenNode* node = static_cast<const traversability_generator3d::TravGenNode*>(pair.first);
-        const double cost = pair.second;
-        travNodeIdToDistance[node->getUserData().id].distToStart = cost;
+        Dijkstra::computeCost(source, outDistances, travGen.getNumNodes(), maxDist, travConf);
     }
+}
+
+void EnvironmentXYZTheta::getTravelTimesFromStart(std::vector<double>& outTimes)
+{
+    if(!startXYZNode)
+        throw std::runtime_error("getTravelTimesFromStart: Error, start needs to be set");
 
-    for(const auto pair : costToEnd)
+    precomputeStartCost();
+    const std::vector<double>& distances = travNodeIdToDistance.distToStart;
+    outTimes.resize(travGen.getNumNodes());
+    for(size_t i = 0; i < outTimes.size(); ++i)
     {
-        const traversability_generator3d::TravGenNode* node = static_cast<const traversability_generator3d::TravGenNode*>(pair.first);
-        const double cost = pair.second;
-        travNodeIdToDistance[node->getUserData().id].distToGoal = cost;
+        //nodes that have been generated after the field was computed have not been reached
+        const double dist = i < distances.size() ? distances[i] : maxDist;
+        outTimes[i] = dist >= maxDist ? std::numeric_limits<double>::infinity() : dist / mobilityConfig.translationSpeed;
     }
 }
 
+bool EnvironmentXYZTheta::isReachableFromStart(const traversability_generator3d::TravGenNode* node) const
+{
+    const size_t id = node->getUserData().id;
+    return id < travNodeIdToDistance.distToStart.size() && travNodeIdToDistance.distToStart[id] < maxDist;
+}
+
 traversability_generator3d::TraversabilityGenerator3d& EnvironmentXYZTheta::getTravGen()
 {
     return travGen;
@@ -1240,6 +1667,11 @@ traversability_generator3d::TraversabilityGenerator3d& EnvironmentXYZTheta::getO
 void EnvironmentXYZTheta::setTravConfig(const traversability_generator3d::TraversabilityConfig& cfg)
 {
     travConf = cfg;
+    searchGraphOutdated = true;
+    clearMotionChecks();
+    //the footprints depend on the robot size
+    if(mlsGrid)
+        availableMotions.computeFootprints(travConf);
 }
 
 
@@ -1370,7 +1802,7 @@ std::shared_ptr<SubTrajectory> EnvironmentXYZTheta::findTrajectoryOutOfObstacle(
 
 
         PathStatistic stats(travConf);
-        stats.calculateStatistics(nodesOnPath, posesOnObstPath, obsGen.getTraversabilityMap());
+        stats.calculateStatistics(startNodeObstMap, availableMotions.getFootprint(motion.id), obsGen.getTraversabilityMap());
         const int obstacleCount = stats.getRobotStats().getNumObstacles() + stats.getRobotStats().getNumFrontiers();
 
         if(obstacleCount < bestMotionObstacleCount)
@@ -8,6 +8,14 @@
 #include <base/Pose.hpp>
 #include "DiscreteTheta.hpp"
 #include "PreComputedMotions.hpp"
+#include "Dijkstra.hpp"
+#include "ConcurrentStateTable.hpp"
+#include "StateArena.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <trajectory_follower/SubTrajectory.hpp>
 
 std::ostream& operator<< (std::ostream& stream, const DiscreteTheta& angle);
@@ -26,9 +34,9 @@ class EnvironmentXYZTheta : public DiscreteSpaceInformation
 public:
     typedef traversability_generator3d::TraversabilityGenerator3d::MLGrid MLGrid;
 protected:
-    traversability_generator3d::TraversabilityGenerator3d travGen;
+    UpdatableMapGenerator3D travGen;
     ObstacleMapGenerator3D obsGen;
-    std::shared_ptr<MLGrid > mlsGrid;
+    std::shared_ptr<const MLGrid > mlsGrid;
 
     struct EnvironmentXYZThetaException : public SBPL_Exception
     {
@@ -54,34 +62,44 @@ protected:
     /**PlannerData is the userdata inside the XYZNode. */
     struct PlannerData
     {
-        PlannerData() : travNode(nullptr) {};
+        PlannerData() : travNode(nullptr), stateIds(nullptr) {};
 
         /**This is the node that was used to create this XYZNode.*/
         traversability_generator3d::TravGenNode *travNode;
-
-        /**An XYZNode is associated with every ThetaNode that it
-         * shares a state with. This map links to all of them,
-         * sorted by theta. */
-        std::map<DiscreteTheta, ThetaNode *> thetaToNodes;
+        /**The state ids of all orientations at this position, see ConcurrentStateTable */
+        std::atomic<int> *stateIds;
     };
 
-    /** The distance from somewhere to start-node and goal-node.*/
-    struct Distance
+    /** The distance from every travNode to start-node and goal-node.
+     *  Both fields are indexed by the id of the travNode. */
+    struct DistanceField
     {
-        double distToStart = 0;
-        double distToGoal = 0;
-        Distance(double toStart, double toGoal) : distToStart(toStart), distToGoal(toGoal){}
+        std::vector<double> distToStart;
+        std::vector<double> distToGoal;
+
+        void clear()
+        {
+            distToStart.clear();
+            distToGoal.clear();
+        }
     };
 
     /** A position on the traversability map */
     typedef maps::grid::TraversabilityNode<PlannerData> XYZNode;
 
-    //search space without theta
-    maps::grid::TraversabilityMap3d<XYZNode *> searchGrid;
+    /** Search space without theta. The XYZNode of every travNode, indexed by the id of the travNode.
+     *  Entries are created concurrently using compare and swap, see getOrCreateXYZNode() */
+    std::vector<std::atomic<XYZNode *>> travNodeIdToXYZNode;
+
+    /** Maps (XYZNode, theta) to sbpl state ids. Holds one id slot per orientation for every XYZNode */
+    ConcurrentStateTable stateTable;
 
     /** Represents one state in the search space */
     struct Hash
     {
+        Hash() : node(nullptr), thetaNode(nullptr)
+        {
+        }
         Hash(XYZNode *node, ThetaNode *thetaNode) : node(node), thetaNode(thetaNode)
         {
         }
@@ -89,15 +107,51 @@ protected:
         ThetaNode *thetaNode;/** < angle of the state and additional meta data */
     };
 
-    /**maps sbpl state ids to internal planner state (Hash). */
+    /**maps sbpl state ids to internal planner state (Hash).
+     * Is resized in reserveStates(), the number of states is stateTable.size() */
     std::vector<Hash> idToHash;
 
+    /** Storage of all states. The memory is kept by clear() and reused by the next plan */
+    StateArena<XYZNode> xyzNodeArena;
+    StateArena<ThetaNode> thetaNodeArena;
+    /** Storage of the rows of StateID2IndexMapping */
+    StateArena<std::array<int, NUMOFINDICES_STATEID2IND>> stateIndexRowArena;
+
     /**Contains the distance from each travNode to start-node and goal-node
      * Stored in real-world coordinates (i.e. do NOT scale with gridResolution before use)*/
-    std::vector<Distance> travNodeIdToDistance;
+    DistanceField travNodeIdToDistance;
+
+    /** Backward search from the goal that is used instead of travNodeIdToDistance.distToGoal
+     *  if the lazy heuristic is enabled. It is resumed on demand in GetGoalHeuristic() */
+    ResumableDijkstra lazyGoalDistance;
 
     PreComputedMotions availableMotions;
 
+    /** Results of the obstacle map checks (see checkMotionOnObstacleMap()) of all motions that start
+     *  on an obstacle node. Every visited obstacle node gets a block of numAngles entries, one per
+     *  start theta. Each entry points to one value per motion of getMotionForStartTheta(), 0 means not checked yet.
+     *  The checks only depend on the maps and the configuration, thus the cache survives clear() and
+     *  is dropped whenever one of them changes.
+     *
+     *  This vector holds the block of every obstacle node, indexed by its id. The upper 32 bits are the
+     *  generation of the block, the lower 32 bits the block index + 1. Blocks of older generations are
+     *  dropped. Is resized in expandMap() */
+    std::vector<std::atomic<uint64_t>> obstNodeToMotionCheckBlock;
+    /** Storage of the blocks, motionCheckBlocksPerChunk blocks per chunk. Has one (possibly empty) chunk
+     *  for every obstacle node that may be visited, thus it does not grow during the search */
+    std::vector<std::unique_ptr<std::atomic<std::atomic<float>*>[]>> motionCheckBlockChunks;
+    /** Number of blocks in use */
+    size_t motionCheckBlocksUsed;
+    /** Is incremented by clearMotionChecks() */
+    uint32_t motionCheckGeneration;
+    static constexpr size_t motionCheckBlocksPerChunk = 256;
+    /** Storage of the values the blocks point to. The values are carved out of chunks of
+     *  motionCheckChunkSize values, the chunks are kept by clearMotionChecks() */
+    std::vector<std::unique_ptr<std::atomic<float>[]>> motionCheckChunks;
+    /** Number of values in motionCheckChunks that are in use, including the unused ends of full chunks */
+    size_t motionChecksUsed;
+    static constexpr size_t motionCheckChunkSize = 1 << 16;
+
     ThetaNode *startThetaNode;
     XYZNode *startXYZNode; //part of the start state
     ThetaNode *goalThetaNode;
@@ -106,8 +160,9 @@ protected:
     /**Start node in obstacle map */
     traversability_generator3d::TravGenNode* obstacleStartNode;
 
-    ThetaNode *createNewState(const DiscreteTheta& curTheta, EnvironmentXYZTheta::XYZNode* curNode);
-    XYZNode *createNewXYZState(traversability_generator3d::TravGenNode* travNode);
+    /** @return the XYZNode of @p travNode. It is created if it does not exist yet.
+     *  Thread-safe as long as the id of @p travNode is covered by reserveStates() */
+    XYZNode *getOrCreateXYZNode(traversability_generator3d::TravGenNode* travNode);
     ThetaNode *createNewStateFromPose(const std::string& name, const Eigen::Vector3d& pos, double theta, ugv_nav4d::EnvironmentXYZTheta::XYZNode** xyzBackNode);
 
     bool checkStartGoalNode(const std::string& name, traversability_generator3d::TravGenNode* node, double theta);
@@ -126,24 +181,41 @@ public:
     Eigen::Vector3d robotHalfSize;
 
     /** @param generateDebugData If true, lots of debug information will becollected
-     *                           and stored in members starting with debug*/
-    EnvironmentXYZTheta(std::shared_ptr<MLGrid > mlsGrid,
+     *                           and stored in members starting with debug
+     *  @param motionCacheDirectory See PreComputedMotions::setCacheDirectory() */
+    EnvironmentXYZTheta(std::shared_ptr<const MLGrid > mlsGrid,
                         const traversability_generator3d::TraversabilityConfig &travConf,
                         const sbpl_spline_primitives::SplinePrimitivesConfig &primitiveConfig,
-                        const Mobility& mobilityConfig);
+                        const Mobility& mobilityConfig,
+                        const std::string& motionCacheDirectory = "");
 
     virtual ~EnvironmentXYZTheta();
 
-    void updateMap(std::shared_ptr<MLGrid > mlsGrid);
+    /** Replaces the map. The environment only reads @p mlsGrid and keeps a reference to it.
+     *  The owner must not modify the grid afterwards, but copy it and hand over the copy.*/
+    void updateMap(std::shared_ptr<const MLGrid > mlsGrid);
+
+    /** Replaces the map, assuming that only the cells inside @p changedRegion (map frame)
+     *  differ from the current map.
+     *  Only the trav and obstacle nodes that are close enough to the region to be affected by
+     *  it are generated again from the new grid, all other nodes are kept. The search graph is cleared.
+     *  Falls back to updateMap(mlsGrid) if the geometry of the grid changed.*/
+    void updateMap(std::shared_ptr<const MLGrid > mlsGrid, const Eigen::AlignedBox3d& changedRegion);
     void setInitialPatch(const Eigen::Affine3d &ground2Mls, double patchRadius);
 
     virtual bool InitializeEnv(const char* sEnvFile);
     virtual bool InitializeMDPCfg(MDPConfig* MDPCfg);
 
 
-    /**Expand the underlying travmap and obstacle map starting from all given positions. */
+    /**Expand the underlying travmap and obstacle map starting from all given positions.
+     * Does nothing if the map did not change since the last expansion and all positions
+     * are already part of the expanded maps. */
     void expandMap(const std::vector<Eigen::Vector3d>& positions);
 
+    /** @return a counter that is increased every time the map changes in a way that
+     *          requires the traversability map to be expanded again */
+    size_t getMapGeneration() const;
+
     /**Returns the trajectory of least resistance to leave the obstacle.
      * @param start start position that is inside an obstacle
      * @param theta robot orientation
@@ -168,6 +240,34 @@ public:
      */
     virtual int GetGoalHeuristic(int stateID);
 
+    /** A feasible motion starting at a given state. */
+    struct SuccessorCandidate
+    {
+        traversability_generator3d::TravGenNode *travNode; /**< node at the end of the motion */
+        const Motion *motion;
+        int cost;
+    };
+
+    /** Computes all feasible motions that start at @p SourceStateID.
+     *  No states are created, thus this method may be called concurrently for different states
+     *  as long as no states are created or reserved at the same time. */
+    void getSuccessorCandidates(int SourceStateID, std::vector<SuccessorCandidate>& candidates);
+
+    /** Makes room for @p numNewStates additional states and for all travNodes that exist
+     *  at the moment. Creating and publishing up to @p numNewStates states does not allocate afterwards.
+     *  Not thread-safe. */
+    void reserveStates(size_t numNewStates);
+
+    /** @return the id of the state at @p travNode with orientation @p theta.
+     *          The state is created if it does not exist yet.
+     *  Lock-free and thread-safe as long as the new states have been reserved using reserveStates().
+     *  New states are not visible to sbpl until publishStates() has been called. */
+    int getOrCreateState(traversability_generator3d::TravGenNode* travNode, const DiscreteTheta& theta);
+
+    /** Adds the sbpl bookkeeping (StateID2IndexMapping) for all states that have been created
+     *  since the last call. Not thread-safe. */
+    void publishStates();
+
     virtual void GetPreds(int TargetStateID, std::vector< int >* PredIDV, std::vector< int >* CostV);
     virtual void GetSuccs(int SourceStateID, std::vector< int >* SuccIDV, std::vector< int >* CostV);
     virtual void GetSuccs(int SourceStateID, std::vector< int >* SuccIDV, std::vector< int >* CostV, std::vector< size_t >& motionIdV);
@@ -180,15 +280,39 @@ public:
     virtual int SizeofCreatedEnv();
 
     void setStart(const Eigen::Vector3d &startPos, double theta);
-    void setGoal(const Eigen::Vector3d &goalPos, double theta);
+
+    /** @param computeHeuristic If false, the goal is only validated and the (expensive) goal
+     *                          heuristic is not computed. In that case precomputeCost() has to
+     *                          be called once a goal has been accepted. This allows testing many
+     *                          goal candidates cheaply. Reachability from the start is only checked
+     *                          here if the start field is available (see setStartHeuristicRequired()),
+     *                          otherwise precomputeCost() checks it.
+     *  @throw std::runtime_error if the goal is invalid or not reachable */
+    void setGoal(const Eigen::Vector3d &goalPos, double theta, bool computeHeuristic = true);
+
+    /** Computes the heuristic for the current start and goal.
+     *  The distance field of the start is only computed if it is required by the search
+     *  (see setStartHeuristicRequired()). It is computed once per start and is reused
+     *  for all subsequent goals.
+     *  @throw std::runtime_error if the goal is not reachable from the start */
+    void precomputeCost();
 
     maps::grid::Vector3d getStatePosition(const int stateID) const;
 
+    /** @return the key of the state @p stateID in the state table: (travNode id, theta) */
+    std::pair<size_t, int> getStateKey(const int stateID) const;
+
 
     /**returns the motion connection @p fromStateID and @p toStateID.
+     * The motion is looked up by the offset and the orientations of the states, only the
+     * cost of the matching motions is computed again. The states are not expanded.
      * @throw std::runtime_error if no matching motion exists*/
     const Motion& getMotion(const int fromStateID, const int toStateID);
 
+    /** @return the sum of the edge costs along @p stateIDPath (in sbpl cost units, see Motion::costScaleFactor)
+     *  @throw std::runtime_error if two consecutive states are not connected */
+    int getPathCost(const std::vector<int> &stateIDPath);
+
     const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &getTraversabilityMap() const;
     const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &getObstacleMap() const;
 
@@ -202,11 +326,25 @@ public:
     void getTrajectory(const std::vector<int> &stateIDPath, std::vector<trajectory_follower::SubTrajectory> &result,
                        bool setZToZero, const Eigen::Vector3d &startPos, const Eigen::Vector3d &goalPos, const double& goalHeading, const Eigen::Affine3d &plan2Body = Eigen::Affine3d::Identity());
 
+    /** Generates the 2D (z set to zero) and the 3D trajectory of @p stateIDPath in one pass.
+     *  The motions and the nodes along the path are only looked up once for both trajectories.
+     *  @param result2D may be nullptr if the 2D trajectory is not needed
+     *  @param result3D may be nullptr if the 3D trajectory is not needed */
+    void getTrajectories(const std::vector<int> &stateIDPath, std::vector<trajectory_follower::SubTrajectory> *result2D,
+                         std::vector<trajectory_follower::SubTrajectory> *result3D, const Eigen::Vector3d &startPos,
+                         const Eigen::Vector3d &goalPos, const double& goalHeading, const Eigen::Affine3d &plan2Body = Eigen::Affine3d::Identity());
+
     const PreComputedMotions& getAvailableMotions() const;
 
     /**Clears the state of the environment. Clears everything except the mls map. */
     void clear();
 
+    /** Prepares the environment for a new search with a new start and goal.
+     *  Unlike clear(), the states and the goal heuristic of previous searches are kept,
+     *  as long as neither the map nor the configuration changed and the map has not been expanded since then.
+     *  @param maxStates if more states have been created, clear() is called instead. 0 means unbounded */
+    void clearForReplanning(size_t maxStates = 0);
+
     void setTravConfig(const traversability_generator3d::TraversabilityConfig& cfg);
 
     /** @param maxDist The value that should be used as maximum distance. This value is used for
@@ -218,6 +356,26 @@ public:
      *  is in collision with obstacles. This mode is useful for highly cluttered and tight spaced environments */
     void enablePathStatistics(bool enable);
 
+    /** If enabled, the distance fields of the heuristic are computed using the parallel
+     *  delta-stepping algorithm (see Dijkstra::computeCostParallel()).
+     *  @param bucketWidth Width of the delta-stepping buckets in meter */
+    void setParallelHeuristic(bool enable, double bucketWidth);
+
+    /** If enabled, the goal distances are not precomputed for the whole map. Instead they are computed
+     *  on demand by a resumable backward search from the goal, that only runs until the queried node
+     *  is settled. This keeps the heuristic cheap for short queries on large maps. */
+    void enableLazyHeuristic(bool enable);
+
+    /** The start heuristic (GetStartHeuristic()) is only needed by backward and bidirectional searches.
+     *  If @p required is false, the distance field of the start is not computed by precomputeCost()
+     *  but on demand, when it is needed for the first time. */
+    void setStartHeuristicRequired(bool required);
+
+    /** Computes the travel time (in seconds) from the start to every node of the traversability map,
+     *  using the same distance field as the start heuristic. The start has to be set.
+     *  @param outTimes indexed by TravGenNode id (getUserData().id). Unreachable nodes are infinity. */
+    void getTravelTimesFromStart(std::vector<double>& outTimes);
+
 private:
 
     /** Check if all nodes on the path from @p sourceNode following @p motion are traversable.
@@ -231,15 +389,66 @@ private:
     bool checkOrientationAllowed(const traversability_generator3d::TravGenNode* node,
                                  const base::Orientation2D& orientation) const;
 
-
-    /** Computes the heuristic */
-    void precomputeCost();
+    /** Lookup in the distance layer of the obstacle map.
+     *  @param path Obstacle map nodes of the poses of a motion
+     *  @param corridor Additional distance around the robot box that needs to be clear
+     *  @return true if no obstacle or frontier can touch the robot (plus @p corridor) at any
+     *          pose of @p path. If false, the footprint of the motion needs to be checked. */
+    bool isClearOfObstacles(const std::vector<const traversability_generator3d::TravGenNode*>& path, double corridor) const;
+
+    /** Checks @p motion on the obstacle map: collisions, incline limits, slope and clearance.
+     *  @param sourceTravNode The trav node of the start state, used for the slope of point turns
+     *  @return the factor that is applied to the cost of the motion, < 0 if the motion is not possible */
+    float checkMotionOnObstacleMap(traversability_generator3d::TravGenNode* sourceObstacleNode,
+                                   const traversability_generator3d::TravGenNode* sourceTravNode,
+                                   const Motion& motion);
+
+    /** Checks @p motion starting at the state @p source and computes its cost.
+     *  @param motionCheck cached result of checkMotionOnObstacleMap() for @p motion, may be nullptr
+     *  @return false if the motion is not possible, otherwise @p candidate is filled in */
+    bool getSuccessor(const Hash& source, traversability_generator3d::TravGenNode* sourceObstacleNode,
+                      const Motion& motion, std::atomic<float>* motionCheck, SuccessorCandidate& candidate);
+
+    /** @return the cheapest motion from @p fromStateID to @p toStateID, see getMotion()
+     *  @throw std::runtime_error if there is no such motion */
+    SuccessorCandidate getConnection(const int fromStateID, const int toStateID);
+
+    /** @return the cached obstacle map checks of the @p numMotions motions starting at @p obstacleNode
+     *          with orientation @p theta. They are allocated on first use.
+     *          nullptr if the node is not covered by reserveMotionChecks().
+     *  Thread-safe */
+    std::atomic<float>* getMotionChecks(const traversability_generator3d::TravGenNode* obstacleNode,
+                                        const DiscreteTheta& theta, size_t numMotions);
+
+    /** Makes room in obstNodeToMotionCheckBlock for all existing obstacle nodes. Not thread-safe */
+    void reserveMotionChecks();
+
+    /** Drops all cached obstacle map checks. Needs to be called if the obstacle map,
+     *  the configuration or the enabled checks change. Does not visit the blocks */
+    void clearMotionChecks();
+
+    /** Computes the distances from the start to all reachable nodes if they have not been
+     *  computed for the current start yet. */
+    void precomputeStartCost();
+
+    /** Computes the distances from the goal to all reachable nodes.
+     *  If the lazy heuristic is enabled, only the backward search is initialized. */
+    void precomputeGoalCost();
+
+    /** Computes the distance from @p source to all reachable nodes using the configured algorithm */
+    void computeDistanceField(const traversability_generator3d::TravGenNode* source, std::vector<double>& outDistances) const;
+
+    /** @return the distance from @p node to the goal */
+    double getGoalDistance(const traversability_generator3d::TravGenNode* node);
+
+    /** @return true if @p node has been reached by the distance field of the start */
+    bool isReachableFromStart(const traversability_generator3d::TravGenNode* node) const;
 
     /**Return the avg slope of all patches on the given @p path */
-    double getAvgSlope(std::vector<const traversability_generator3d::TravGenNode*> path) const;
+    double getAvgSlope(const std::vector<const traversability_generator3d::TravGenNode*>& path) const;
 
     /**Returns the max slope of all patches on the given @p path */
-    double getMaxSlope(std::vector<const traversability_generator3d::TravGenNode*> path) const;
+    double getMaxSlope(const std::vector<const traversability_generator3d::TravGenNode*>& path) const;
 
 
     /**Determines the distance between @p a and @p b depending on travConf.heuristicType */
@@ -258,6 +467,30 @@ private:
 
     bool usePathStatistics;
 
+    /** True if distToStart in travNodeIdToDistance is valid for the current start */
+    bool startCostValid;
+
+    bool parallelHeuristic;
+    double deltaSteppingBucketWidth;
+    bool lazyHeuristic;
+    bool startHeuristicRequired;
+
+    /** The goal node and map size for which the goal distances have been computed.
+     *  Used to skip the computation if the goal did not change. */
+    const traversability_generator3d::TravGenNode* goalCostNode;
+    size_t goalCostNumNodes;
+
+    /** True if the states or successors do not match the current map or configuration anymore */
+    bool searchGraphOutdated;
+
+    /** See getMapGeneration() */
+    size_t mapGeneration;
+    /** The map generation of the last expandMap() */
+    size_t expandedGeneration;
+
+    /** @return true if all @p positions are on expanded nodes of the trav and the obstacle map */
+    bool isExpanded(const std::vector<Eigen::Vector3d>& positions);
+
     traversability_generator3d::TraversabilityConfig travConf;
     sbpl_spline_primitives::SplinePrimitivesConfig primitiveConfig;
 
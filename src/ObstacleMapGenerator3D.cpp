@@ -1,4 +1,7 @@
 #include "ObstacleMapGenerator3D.hpp"
+#include <algorithm>
+#include <limits>
+#include <queue>
 #include <vizkit3d_debug_drawings/DebugDrawing.hpp>
 #include <vizkit3d_debug_drawings/DebugDrawingColors.hpp>
 
@@ -7,7 +10,8 @@ using namespace maps::grid;
 namespace ugv_nav4d
 {
     
-ObstacleMapGenerator3D::ObstacleMapGenerator3D(const traversability_generator3d::TraversabilityConfig& config): TraversabilityGenerator3d(config)
+ObstacleMapGenerator3D::ObstacleMapGenerator3D(const traversability_generator3d::TraversabilityConfig& config): UpdatableMapGenerator3D(config),
+    distanceLayerValid(false)
 {
 
 }
@@ -21,6 +25,7 @@ ObstacleMapGenerator3D::~ObstacleMapGenerator3D()
 bool ObstacleMapGenerator3D::expandNode(traversability_generator3d::TravGenNode *node)
 {    
     node->setExpanded();
+    expandedSinceUpdate.push_back(node);
 
     if(node->getType() == TraversabilityNodeBase::UNKNOWN)
     {   
@@ -69,30 +74,214 @@ bool ObstacleMapGenerator3D::expandNode(traversability_generator3d::TravGenNode
 }
 
 
-bool ObstacleMapGenerator3D::obstacleCheck(const traversability_generator3d::TravGenNode* node) const
+void ObstacleMapGenerator3D::setMLSGrid(const std::shared_ptr<MLGrid>& mlsGrid)
+{
+    //the columns belong to the old grid and the layer refers to the deleted nodes
+    clearPatchColumns();
+    clearDistanceLayer();
+    UpdatableMapGenerator3D::setMLSGrid(mlsGrid);
+}
+
+size_t ObstacleMapGenerator3D::updateRegion(std::shared_ptr<MLGrid> mlsGrid, const Index& min, const Index& max)
+{
+    //only the nodes of the region are generated again, thus rebuilding the columns on demand is cheap
+    clearPatchColumns();
+    //the layer refers to the removed nodes and obstacles may have become traversable
+    clearDistanceLayer();
+    return UpdatableMapGenerator3D::updateRegion(mlsGrid, min, max);
+}
+
+bool ObstacleMapGenerator3D::obstacleCheck(const traversability_generator3d::TravGenNode* node)
 {
     //check if there is an mls patch above the ground
     Eigen::Vector3d nodePos;
     if(!trMap.fromGrid(node->getIndex(), nodePos, node->getHeight()))
         throw std::runtime_error("ObstacleMapGenerator3D: Internal error node out of grid");
 
-    Eigen::Vector3d min(-config.gridResolution/2.0 + 1e-5, -config.gridResolution / 2.0 + 1e-5, config.maxStepHeight);
-    Eigen::Vector3d max(config.gridResolution/2.0 - 1e-5, config.gridResolution/2.0 - 1e-5, config.robotHeight);
-    
-    
-    min += nodePos;
-    max += nodePos;
-    
-    const Eigen::AlignedBox3d boundingBox(min, max);
-    
-//     V3DD::DRAW_AABB("obstacle map box", boundingBox, V3DD::Color::cyan);
-    size_t numIntersections = 0;
-    const View area = mlsGrid->intersectCuboid(Eigen::AlignedBox3d(min, max), numIntersections);
-    if(numIntersections > 0)
-        return false;
-    
+    //all mls cells that overlap the cell of the node
+    const double halfCell = config.gridResolution / 2.0 - 1e-5;
+    Index minIdx, maxIdx;
+    mlsGrid->toGrid(nodePos - Eigen::Vector3d(halfCell, halfCell, 0), minIdx, false);
+    mlsGrid->toGrid(nodePos + Eigen::Vector3d(halfCell, halfCell, 0), maxIdx, false);
+    minIdx = minIdx.cwiseMax(Index(0, 0));
+    maxIdx = maxIdx.cwiseMin(Index((int)mlsGrid->getNumCells().x() - 1, (int)mlsGrid->getNumCells().y() - 1));
+
+    const double minZ = nodePos.z() + config.maxStepHeight;
+    const double maxZ = nodePos.z() + config.robotHeight;
+    for(int y = minIdx.y(); y <= maxIdx.y(); ++y)
+    {
+        for(int x = minIdx.x(); x <= maxIdx.x(); ++x)
+        {
+            if(intersects(getPatchColumn(Index(x, y)), minZ, maxZ))
+                return false;
+        }
+    }
+
     return true;
 }
 
+const ObstacleMapGenerator3D::PatchColumn& ObstacleMapGenerator3D::getPatchColumn(const Index& idx)
+{
+    const size_t numCells = mlsGrid->getNumCells().x() * mlsGrid->getNumCells().y();
+    if(patchColumns.size() != numCells)
+        patchColumns.resize(numCells);
+
+    PatchColumn &column(patchColumns[idx.y() * mlsGrid->getNumCells().x() + idx.x()]);
+    if(column.valid)
+        return column;
+
+    //one pass over the patch list of the cell, overlapping patches are merged
+    column.begin = columnIntervals.size();
+    for(const auto &patch : mlsGrid->at(idx))
+        columnIntervals.push_back(std::make_pair(patch.getMin(), patch.getMax()));
+    std::sort(columnIntervals.begin() + column.begin, columnIntervals.end());
+
+    size_t last = column.begin;
+    for(size_t i = column.begin + 1; i < columnIntervals.size(); ++i)
+    {
+        if(columnIntervals[i].first <= columnIntervals[last].second)
+            columnIntervals[last].second = std::max(columnIntervals[last].second, columnIntervals[i].second);
+        else
+            columnIntervals[++last] = columnIntervals[i];
+    }
+    if(columnIntervals.size() > column.begin)
+        columnIntervals.resize(last + 1);
+    column.size = columnIntervals.size() - column.begin;
+    column.valid = true;
+    return column;
+}
+
+bool ObstacleMapGenerator3D::intersects(const PatchColumn& column, double minZ, double maxZ) const
+{
+    const auto begin = columnIntervals.begin() + column.begin;
+    const auto end = begin + column.size;
+    //the intervals are disjoint, thus the tops are sorted as well
+    const auto it = std::lower_bound(begin, end, minZ, [] (const std::pair<float, float> &interval, double z)
+    {
+        return interval.second < z;
+    });
+    return it != end && it->first <= maxZ;
+}
+
+void ObstacleMapGenerator3D::clearPatchColumns()
+{
+    patchColumns.clear();
+    columnIntervals.clear();
+}
+
+
+void ObstacleMapGenerator3D::clearDistanceLayer()
+{
+    //the nodes may have been deleted
+    expandedSinceUpdate.clear();
+    obstacleDistances.distance.clear();
+    obstacleDistances.nearest.clear();
+    frontierDistances.distance.clear();
+    frontierDistances.nearest.clear();
+    distanceLayerValid = false;
+}
+
+void ObstacleMapGenerator3D::updateDistanceLayer()
+{
+    if(!distanceLayerValid)
+    {
+        expandedSinceUpdate.clear();
+        for(int y = 0; y < (int)trMap.getNumCells().y(); ++y)
+        {
+            for(int x = 0; x < (int)trMap.getNumCells().x(); ++x)
+            {
+                for(traversability_generator3d::TravGenNode *node : trMap.at(Index(x, y)))
+                {
+                    if(node->isExpanded())
+                        expandedSinceUpdate.push_back(node);
+                }
+            }
+        }
+        distanceLayerValid = true;
+    }
+
+    std::vector<traversability_generator3d::TravGenNode*> obstacles;
+    std::vector<traversability_generator3d::TravGenNode*> frontiers;
+    for(traversability_generator3d::TravGenNode *node : expandedSinceUpdate)
+    {
+        switch(node->getType())
+        {
+            case TraversabilityNodeBase::TRAVERSABLE:
+                break;
+            case TraversabilityNodeBase::FRONTIER:
+                frontiers.push_back(node);
+                break;
+            default:
+                obstacles.push_back(node);
+                break;
+        }
+    }
+    expandedSinceUpdate.clear();
+
+    propagate(obstacleDistances, obstacles);
+    propagate(frontierDistances, frontiers);
+}
+
+void ObstacleMapGenerator3D::propagate(DistanceLayer& layer, const std::vector<traversability_generator3d::TravGenNode*>& seeds)
+{
+    //new nodes have not been reached by any seed so far
+    layer.distance.resize(getNumNodes(), std::numeric_limits<float>::infinity());
+    layer.nearest.resize(getNumNodes(), Index(0, 0));
+
+    typedef std::pair<float, traversability_generator3d::TravGenNode*> Entry;
+    auto greater = [] (const Entry &a, const Entry &b) { return a.first > b.first; };
+    std::priority_queue<Entry, std::vector<Entry>, decltype(greater)> queue(greater);
+
+    for(traversability_generator3d::TravGenNode *seed : seeds)
+    {
+        const size_t id = seed->getUserData().id;
+        layer.distance[id] = 0;
+        layer.nearest[id] = seed->getIndex();
+        queue.push(Entry(0, seed));
+    }
+
+    while(!queue.empty())
+    {
+        const Entry entry = queue.top();
+        queue.pop();
+        const size_t id = entry.second->getUserData().id;
+        if(entry.first > layer.distance[id])
+            continue; //outdated entry
+
+        //each node inherits the closest seed of a neighbor, this is exact in almost all cases
+        const Index &nearest(layer.nearest[id]);
+        for(TraversabilityNodeBase *connected : entry.second->getConnections())
+        {
+            traversability_generator3d::TravGenNode *neighbor = static_cast<traversability_generator3d::TravGenNode*>(connected);
+            const size_t neighborId = neighbor->getUserData().id;
+            const float dist = (neighbor->getIndex() - nearest).cast<float>().norm() * config.gridResolution;
+            if(dist < layer.distance[neighborId])
+            {
+                layer.distance[neighborId] = dist;
+                layer.nearest[neighborId] = nearest;
+                queue.push(Entry(dist, neighbor));
+            }
+        }
+    }
+}
+
+double ObstacleMapGenerator3D::getDistance(const DistanceLayer& layer, const traversability_generator3d::TravGenNode* node) const
+{
+    const size_t id = node->getUserData().id;
+    //unexpanded nodes may be obstacles, they only inherit distances through their connections
+    if(id >= layer.distance.size() || !node->isExpanded())
+        return 0;
+    return layer.distance[id];
+}
+
+double ObstacleMapGenerator3D::getObstacleDistance(const traversability_generator3d::TravGenNode* node) const
+{
+    return getDistance(obstacleDistances, node);
+}
+
+double ObstacleMapGenerator3D::getFrontierDistance(const traversability_generator3d::TravGenNode* node) const
+{
+    return getDistance(frontierDistances, node);
+}
 
 }
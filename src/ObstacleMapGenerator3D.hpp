@@ -1,19 +1,97 @@
 #pragma once
-#include <traversability_generator3d/TraversabilityGenerator3d.hpp>
+#include "UpdatableMapGenerator3D.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace ugv_nav4d
 {
-    class ObstacleMapGenerator3D : public traversability_generator3d::TraversabilityGenerator3d
+    class ObstacleMapGenerator3D : public UpdatableMapGenerator3D
     {
     public:
         ObstacleMapGenerator3D(const traversability_generator3d::TraversabilityConfig &config);
         virtual ~ObstacleMapGenerator3D();
         virtual bool expandNode(traversability_generator3d::TravGenNode *node) override;
+        virtual size_t updateRegion(std::shared_ptr<MLGrid> mlsGrid, const maps::grid::Index &min, const maps::grid::Index &max) override;
+
+        /** Replaces the mls grid and clears the whole map, the patch columns and the distance layer */
+        void setMLSGrid(const std::shared_ptr<MLGrid> &mlsGrid);
 //         virtual traversability_generator3d::TravGenNode *generateStartNode(const Eigen::Vector3d &startPos) override;
-        
+
+        /** Brings the distance layer up to date with the nodes that have been expanded since the last call.
+         *  New obstacles and frontiers are propagated incrementally. After clearDistanceLayer() the
+         *  layer is rebuilt from all nodes of the map.
+         *  @note Not thread safe, must not be called while the map is used by a search. */
+        void updateDistanceLayer();
+
+        /** Needs to be called whenever nodes may have changed their type in a way that increases
+         *  distances, i.e. after setInitialPatch(). setMLSGrid() and updateRegion() do it on their own. */
+        void clearDistanceLayer();
+
+        /** @return the distance (in m, in the xy plane) from the center of @p node to the center of the
+         *          closest obstacle node that is reachable via connections. Obstacles are all nodes
+         *          that are neither traversable nor frontiers.
+         *          Infinity if there is no obstacle, 0 if the node is not part of the layer yet.
+         *  @note The distances are propagated between neighbors and may overestimate the euclidean
+         *        distance by a fraction of a cell. */
+        double getObstacleDistance(const traversability_generator3d::TravGenNode *node) const;
+
+        /** Same as getObstacleDistance() but for frontier nodes */
+        double getFrontierDistance(const traversability_generator3d::TravGenNode *node) const;
+
     private:
-        
-        /** @return true if obstacle check passed */
-        bool obstacleCheck(const traversability_generator3d::TravGenNode* node) const;
+        /** Drops the cached patch columns of the mls grid (see obstacleCheck()).
+         *  Is called whenever the grid is replaced */
+        void clearPatchColumns();
+
+
+        /** @return true if there is no mls patch between maxStepHeight and robotHeight above @p node */
+        bool obstacleCheck(const traversability_generator3d::TravGenNode* node);
+
+        /** The vertical extent of all patches of one mls cell, merged into disjoint
+         *  intervals that are sorted from bottom to top */
+        struct PatchColumn
+        {
+            PatchColumn() : begin(0), size(0), valid(false)
+            {
+            }
+            /** first interval in columnIntervals */
+            uint32_t begin;
+            uint32_t size;
+            bool valid;
+        };
+
+        /** @return the column of the mls cell @p idx, it is computed on first use */
+        const PatchColumn &getPatchColumn(const maps::grid::Index &idx);
+
+        /** @return true if a patch of @p column intersects the height range [@p minZ, @p maxZ] */
+        bool intersects(const PatchColumn &column, double minZ, double maxZ) const;
+
+        /** Indexed by the mls cell (y * width + x) */
+        std::vector<PatchColumn> patchColumns;
+        /** (bottom, top) of the intervals of all columns */
+        std::vector<std::pair<float, float>> columnIntervals;
+
+        /** Distance of every node to the closest node of one kind */
+        struct DistanceLayer
+        {
+            /** Indexed by node id. Infinity if no seed is reachable */
+            std::vector<float> distance;
+            /** Indexed by node id. Cell of the closest seed */
+            std::vector<maps::grid::Index> nearest;
+        };
+
+        /** Dijkstra like propagation of the distances from @p seeds. Distances only
+         *  decrease, thus adding seeds to an existing layer is correct. */
+        void propagate(DistanceLayer &layer, const std::vector<traversability_generator3d::TravGenNode*> &seeds);
+
+        double getDistance(const DistanceLayer &layer, const traversability_generator3d::TravGenNode *node) const;
+
+        DistanceLayer obstacleDistances;
+        DistanceLayer frontierDistances;
+        /** Nodes that have been expanded since the last update of the distance layer */
+        std::vector<traversability_generator3d::TravGenNode*> expandedSinceUpdate;
+        /** false if the layer needs to be rebuilt from scratch */
+        bool distanceLayerValid;
     };
 }
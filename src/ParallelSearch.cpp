@@ -0,0 +1,138 @@
+#include "ParallelSearch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <queue>
+#include <base-logging/Logging.hpp>
+
+namespace ugv_nav4d
+{
+
+ParallelSearch::ParallelSearch(EnvironmentXYZTheta& env, size_t batchSize) :
+    env(env), batchSize(std::max<size_t>(batchSize, 1)), numExpands(0), solutionCost(0)
+{
+}
+
+void ParallelSearch::ensureSize(size_t numStates)
+{
+    if(g.size() < numStates)
+    {
+        g.resize(numStates, std::numeric_limits<long long>::max());
+        parent.resize(numStates, -1);
+    }
+}
+
+bool ParallelSearch::search(int startId, int goalId, double epsilon, double maxTime, std::vector<int>& solution)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point startTime = Clock::now();
+
+    solution.clear();
+    numExpands = 0;
+    solutionCost = 0;
+    g.clear();
+    parent.clear();
+    ensureSize(env.SizeofCreatedEnv());
+
+    auto compare = [](const OpenEntry& a, const OpenEntry& b) { return a.f > b.f; };
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, decltype(compare)> open(compare);
+    auto key = [&](long long gValue, int id)
+    {
+        return gValue + static_cast<long long>(epsilon * env.GetGoalHeuristic(id));
+    };
+
+    g[startId] = 0;
+    open.push(OpenEntry{key(0, startId), 0, startId});
+
+    std::vector<int> batch;
+    batch.reserve(batchSize);
+    std::vector<std::vector<EnvironmentXYZTheta::SuccessorCandidate>> candidates(batchSize);
+    std::vector<std::vector<int>> successorIds(batchSize);
+
+    while(!open.empty())
+    {
+        if(std::chrono::duration<double>(Clock::now() - startTime).count() > maxTime)
+        {
+            LOG_INFO_S << "ParallelSearch: ran out of time after " << numExpands << " expansions";
+            return false;
+        }
+
+        batch.clear();
+        while(!open.empty() && batch.size() < batchSize)
+        {
+            const OpenEntry entry = open.top();
+            open.pop();
+            //stale entry, the state has been reached on a cheaper path in the meantime
+            if(entry.g != g[entry.id])
+                continue;
+
+            if(entry.id == goalId)
+            {
+                solutionCost = g[goalId];
+                for(int id = goalId; id != -1; id = parent[id])
+                    solution.push_back(id);
+                std::reverse(solution.begin(), solution.end());
+                return true;
+            }
+            batch.push_back(entry.id);
+        }
+
+        //exceptions must not leave the parallel region
+        std::exception_ptr error;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(int i = 0; i < static_cast<int>(batch.size()); ++i)
+        {
+            try
+            {
+                env.getSuccessorCandidates(batch[i], candidates[i]);
+            }
+            catch(...)
+            {
+                #pragma omp critical(parallelSearchError)
+                error = std::current_exception();
+            }
+        }
+        if(error)
+            std::rethrow_exception(error);
+
+        //every candidate creates at most one new state
+        size_t numCandidates = 0;
+        for(size_t i = 0; i < batch.size(); ++i)
+            numCandidates += candidates[i].size();
+        env.reserveStates(numCandidates);
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(int i = 0; i < static_cast<int>(batch.size()); ++i)
+        {
+            successorIds[i].clear();
+            for(const EnvironmentXYZTheta::SuccessorCandidate& candidate : candidates[i])
+                successorIds[i].push_back(env.getOrCreateState(candidate.travNode, candidate.motion->endTheta));
+        }
+        env.publishStates();
+        ensureSize(env.SizeofCreatedEnv());
+
+        numExpands += batch.size();
+
+        for(size_t i = 0; i < batch.size(); ++i)
+        {
+            const int sourceId = batch[i];
+            for(size_t j = 0; j < candidates[i].size(); ++j)
+            {
+                const int succId = successorIds[i][j];
+                const long long newG = g[sourceId] + candidates[i][j].cost;
+                if(newG < g[succId])
+                {
+                    g[succId] = newG;
+                    parent[succId] = sourceId;
+                    open.push(OpenEntry{key(newG, succId), newG, succId});
+                }
+            }
+        }
+    }
+
+    LOG_INFO_S << "ParallelSearch: state space exhausted after " << numExpands << " expansions";
+    return false;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include "EnvironmentXYZTheta.hpp"
+
+namespace ugv_nav4d
+{
+
+/** Weighted A* search that expands batches of the best states on OPEN in parallel.
+ *
+ *  The successors of a single state are generated single-threaded
+ *  (see EnvironmentXYZTheta::getSuccessorCandidates()), the threads work on different
+ *  states instead. This keeps all threads busy without forking threads for every expansion.
+ *  Successor states are created concurrently as well (see EnvironmentXYZTheta::getOrCreateState()),
+ *  g-values are updated sequentially after each batch.
+ *  States are reopened if a cheaper path to them is found, thus the cost of the solution
+ *  is bounded by epsilon times the optimal cost. */
+class ParallelSearch
+{
+public:
+    /** @param batchSize number of states that are expanded concurrently */
+    ParallelSearch(EnvironmentXYZTheta& env, size_t batchSize);
+
+    /** @param epsilon inflation factor of the heuristic
+     *  @param maxTime maximum wall time in seconds
+     *  @param[out] solution state ids from start to goal
+     *  @return true if a solution was found */
+    bool search(int startId, int goalId, double epsilon, double maxTime, std::vector<int>& solution);
+
+    size_t getNumExpands() const
+    {
+        return numExpands;
+    }
+
+    /** @return cost of the last solution */
+    long long getSolutionCost() const
+    {
+        return solutionCost;
+    }
+
+private:
+    struct OpenEntry
+    {
+        long long f;
+        long long g; /**< g-value at insertion time, used to detect stale entries */
+        int id;
+    };
+
+    void ensureSize(size_t numStates);
+
+    EnvironmentXYZTheta& env;
+    size_t batchSize;
+    size_t numExpands;
+    long long solutionCost;
+
+    /** indexed by state id */
+    std::vector<long long> g;
+    std::vector<int> parent;
+};
+
+}
@@ -1,6 +1,7 @@
 #include "PathStatistic.hpp"
-#include <unordered_set>
-#include <deque>
+#include "PreComputedMotions.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <vizkit3d_debug_drawings/DebugDrawing.hpp>
 #include <vizkit3d_debug_drawings/DebugDrawingColors.hpp>
 
@@ -18,7 +19,7 @@ ugv_nav4d::PathStatistic::Stats::Stats() :
     static_assert(maps::grid::TraversabilityNodeBase::FRONTIER < maps::grid::TraversabilityNodeBase::FRONTIER + 1, "");
     
     
-    minDistance.resize(maps::grid::TraversabilityNodeBase::FRONTIER + 1, std::numeric_limits< double >::max());
+    minDistance.fill(std::numeric_limits< double >::max());
     
     
     minDistToObstacle = std::numeric_limits< double >::max();
@@ -55,6 +56,79 @@ double ugv_nav4d::PathStatistic::Stats::getMinDistToObstacles() const
     return minDistToObstacle;
 }
 
+namespace
+{
+
+/** Per thread buffer of walkFootprint(). It keeps its capacity between calls,
+ *  thus the collision checks do not allocate in the steady state. */
+thread_local std::vector<const traversability_generator3d::TravGenNode*> footprintNodes;
+
+/** Looks up the node of every cell of @p footprint and calls callback(cell, node, stop)
+ *  for each cell that has one. The nodes are stored in @p nodes, indexed like the cells.
+ *  The node of a cell is found via the connections of its parent cells, thus this behaves
+ *  like a flood fill from @p startNode that is restricted to the footprint.
+ *  @return the number of cells that have been visited before @p callback requested a stop */
+template <class Callback>
+size_t walkFootprint(const traversability_generator3d::TravGenNode* startNode, const ugv_nav4d::SweptFootprint &footprint,
+                     std::vector<const traversability_generator3d::TravGenNode*> &nodes, Callback callback)
+{
+    const std::vector<ugv_nav4d::SweptFootprint::Cell> &cells(footprint.getCells());
+    nodes.resize(cells.size());
+    const maps::grid::Index startIdx(startNode->getIndex());
+
+    bool stop = false;
+    for(size_t i = 0; i < cells.size(); ++i)
+    {
+        const ugv_nav4d::SweptFootprint::Cell &cell(cells[i]);
+        const traversability_generator3d::TravGenNode *node = nullptr;
+        if(i == 0)
+        {
+            node = startNode;
+        }
+        else
+        {
+            const maps::grid::Index idx(startIdx + cell.offset);
+            for(uint8_t p = 0; p < cell.numParents && !node; ++p)
+            {
+                const traversability_generator3d::TravGenNode *parent = nodes[cell.parents[p]];
+                if(parent)
+                    node = parent->getConnectedNode(idx);
+            }
+        }
+
+        nodes[i] = node;
+        if(!node)
+            continue;
+
+        callback(cell, node, stop);
+        if(stop)
+            return i + 1;
+    }
+    return cells.size();
+}
+
+/** Footprint of an arbitrary path, relative to the first node of the path */
+ugv_nav4d::SweptFootprint makeFootprint(const std::vector<const traversability_generator3d::TravGenNode*> &path,
+                                        const std::vector<base::Pose2D> &poses,
+                                        const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap,
+                                        const traversability_generator3d::TraversabilityConfig &config)
+{
+    const maps::grid::Index startIdx(path.front()->getIndex());
+    maps::grid::Vector3d startPos;
+    trMap.fromGrid(startIdx, startPos, path.front()->getHeight(), false);
+
+    std::vector<ugv_nav4d::PoseWithCell> steps(path.size());
+    for(size_t i = 0; i < path.size(); ++i)
+    {
+        steps[i].pose = poses[i];
+        steps[i].pose.position -= startPos.head<2>();
+        steps[i].cell = path[i]->getIndex() - startIdx;
+    }
+    return ugv_nav4d::SweptFootprint(steps, config);
+}
+
+}
+
 ugv_nav4d::PathStatistic::PathStatistic(const traversability_generator3d::TraversabilityConfig& config) : 
         config(config)
 {
@@ -66,138 +140,60 @@ void ugv_nav4d::PathStatistic::calculateStatistics(const std::vector<const trave
                                                    const std::string &debugObstacleName)
 {
     assert(path.size() == poses.size());
-//     CLEAR_DRAWING("CollisionBox");
-   
-    const Eigen::Vector2d travGridResolution(config.gridResolution, config.gridResolution);
-
-    Eigen::Vector2d halfRobotDimension(config.robotSizeX / 2.0, config.robotSizeY/2.0);
-    Eigen::Vector2d halfOuterBoxDimension(halfRobotDimension + Eigen::Vector2d::Constant(config.costFunctionDist));
-    
-    std::vector<Eigen::Vector2d> edgePositions = {
-        Eigen::Vector2d(- config.gridResolution /2.0, - config.gridResolution / 2.0),
-        Eigen::Vector2d(- config.gridResolution / 2.0, config.gridResolution / 2.0),
-        Eigen::Vector2d(config.gridResolution / 2.0, config.gridResolution / 2.0),
-        Eigen::Vector2d(config.gridResolution / 2.0, -config.gridResolution / 2.0)
-    };
-    
-    Eigen::AlignedBox<double, 2> robotBoundingBox(- halfRobotDimension, halfRobotDimension);
-    Eigen::AlignedBox<double, 2> costFunctionBoundingBox(- halfOuterBoxDimension, halfOuterBoxDimension);
+    if(path.empty())
+        return;
 
-    std::unordered_set<const maps::grid::TraversabilityNodeBase*> inRobot;
-    std::unordered_set<const maps::grid::TraversabilityNodeBase*> inBoundary;
+    calculateStatistics(path.front(), makeFootprint(path, poses, trMap, config), trMap, debugObstacleName);
+}
 
-    for(size_t i = 0; i < path.size(); i++)
+void ugv_nav4d::PathStatistic::calculateStatistics(const traversability_generator3d::TravGenNode* startNode,
+                                                   const SweptFootprint& footprint,
+                                                   const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap,
+                                                   const std::string &debugObstacleName)
+{
+    std::vector<const traversability_generator3d::TravGenNode*> &nodes(footprintNodes);
+    const size_t numVisited = walkFootprint(startNode, footprint, nodes, [&] (const SweptFootprint::Cell &cell, const traversability_generator3d::TravGenNode *node, bool &stop)
     {
-        const traversability_generator3d::TravGenNode *node(path[i]);
-        const base::Pose2D curPose(poses[i]);
-
-        const Eigen::Rotation2D<double> yawInverse(Eigen::Rotation2D<double>(curPose.orientation).inverse());
+        if(cell.boundaryDistance != std::numeric_limits<double>::infinity())
+        {
+            boundaryStats.updateDistance(node, cell.boundaryDistance);
+        }
 
-        maps::grid::Vector3d nodePos3 = node->getPosition(trMap);
-        const maps::grid::Vector2d nodePos(nodePos3.head<2>());
+        if(!cell.isInsideRobot())
+            return;
 
-        bool hasObstacle = false;
-        
-        node->eachConnectedNode([&] (const maps::grid::TraversabilityNodeBase *neighbor, bool &explandNode, bool &stop){
-            //we need to compute the four edges of a cell and check if any is inside of the robot
-            maps::grid::Vector3d neighborPos;
-            trMap.fromGrid(neighbor->getIndex(), neighborPos, neighbor->getHeight(), false);
-            
-            bool isInsideRobot = false;
-            bool isInsideOuterBox = false;
-            
-            for(const Eigen::Vector2d &ep : edgePositions)
+        robotStats.updateDistance(node, cell.robotDistance);
+        if(node->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
+        {
+#ifdef ENABLE_DEBUG_DRAWINGS                    
+            V3DD::COMPLEX_DRAWING([&]()
             {
-                const Eigen::Vector2d edgePos(neighborPos.head<2>() + ep);
-                
-                //translate to center
-                Eigen::Vector2d tp = edgePos - curPose.position;
-                //rotate invers to orientation of robot
-                tp = yawInverse * tp;
-                
-                if(costFunctionBoundingBox.contains(tp))
+                if(!debugObstacleName.empty())
                 {
-                    isInsideOuterBox = true;
-                    
-                    //it is only inside the robot
-                    if(robotBoundingBox.contains(tp))
-                    {
-                        isInsideRobot = true;
-                        robotStats.updateDistance(neighbor, (nodePos3 - neighborPos).head<2>().norm());
-                        //we continue iteration here, to compute the correct distances of all edges
-                    }
-                    else
-                    {
-                        boundaryStats.updateDistance(neighbor, robotBoundingBox.exteriorDistance(tp));
-                    }
+                    maps::grid::Vector3d nodePos;
+                    trMap.fromGrid(node->getIndex(), nodePos, node->getHeight(), false);
+                    V3DD::DRAW_ARROW(debugObstacleName,
+                                     nodePos,
+                                     Eigen::Quaterniond(Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitX())), Eigen::Vector3d(.3, 0.3, 0.8), V3DD::Color::red);
                 }
-            }
-                
-            if(!isInsideOuterBox)
-            {
-                return;
-            }
-
-            //further expand node
-            explandNode = true;
-
-            if(isInsideRobot)
-            {
-                inRobot.insert(neighbor);
-                
-                if(neighbor->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
-                {
-#ifdef ENABLE_DEBUG_DRAWINGS                    
-                    V3DD::COMPLEX_DRAWING([&]()
-                    {
-                        if(!debugObstacleName.empty())
-                        {
-                        V3DD::DRAW_ARROW(debugObstacleName,
-                                         neighborPos,
-                                         Eigen::Quaterniond(Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitX())), Eigen::Vector3d(.3, 0.3, 0.8), V3DD::Color::red);
-                        }
-                    });
+            });
 #endif                    
-                    hasObstacle = true;
-                    stop = true;
-                }
-                
-                return;
-            }
-            
-            inBoundary.insert(neighbor);
-            
-        });
-        /*
-        if(hasObstacle)
-        {
-            COMPLEX_DRAWING (
-
-            Eigen::Vector3d checkPos;
-            checkPos.head<2>() = curPose.position;
-            checkPos.z() = node->getHeight();
-            
-            DRAW_WIREFRAME_BOX("CollisionBox", checkPos, Eigen::Quaterniond(Eigen::AngleAxisd(curPose.orientation, Eigen::Vector3d::UnitZ())), Eigen::Vector3d(config.robotSizeX, config.robotSizeY, config.robotHeight), vizkit3dDebugDrawings::Color::red);
-            );
-        }*/
-
-        if(hasObstacle)
-            break;
-    }
-
-    for(const maps::grid::TraversabilityNodeBase* n : inBoundary)
-    {
-        if(inRobot.find(n) == inRobot.end())
-        {
-            boundaryStats.updateStatistic(n);
+            stop = true;
         }
-    }   
-    
-    for(const maps::grid::TraversabilityNodeBase* n : inRobot)
+    });
+
+    //the statistics depend on the minimum distances, thus they are updated afterwards
+    const std::vector<SweptFootprint::Cell> &cells(footprint.getCells());
+    for(size_t i = 0; i < numVisited; ++i)
     {
-        robotStats.updateStatistic(n);
-    }   
+        if(!nodes[i])
+            continue;
 
+        if(cells[i].isInsideRobot())
+            robotStats.updateStatistic(nodes[i]);
+        else if(cells[i].isInsideBoundary())
+            boundaryStats.updateStatistic(nodes[i]);
+    }
 }
 
 bool ugv_nav4d::PathStatistic::isPathFeasible(const std::vector<const traversability_generator3d::TravGenNode* >& path, 
@@ -205,89 +201,22 @@ bool ugv_nav4d::PathStatistic::isPathFeasible(const std::vector<const traversabi
                                                    const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap)
 {    
     assert(path.size() == poses.size());
- 
-    const Eigen::Vector2d travGridResolution(config.gridResolution, config.gridResolution);
+    if(path.empty())
+        return true;
 
-    Eigen::Vector2d halfRobotDimension(config.robotSizeX / 2.0, config.robotSizeY/2.0);
-    Eigen::Vector2d halfOuterBoxDimension(halfRobotDimension + Eigen::Vector2d::Constant(config.costFunctionDist));
-    
-    std::vector<Eigen::Vector2d> edgePositions = {
-        Eigen::Vector2d(- config.gridResolution /2.0, - config.gridResolution / 2.0),
-        Eigen::Vector2d(- config.gridResolution / 2.0, config.gridResolution / 2.0),
-        Eigen::Vector2d(config.gridResolution / 2.0, config.gridResolution / 2.0),
-        Eigen::Vector2d(config.gridResolution / 2.0, -config.gridResolution / 2.0)
-    };
-    
-    Eigen::AlignedBox<double, 2> robotBoundingBox(- halfRobotDimension, halfRobotDimension);
-    Eigen::AlignedBox<double, 2> costFunctionBoundingBox(- halfOuterBoxDimension, halfOuterBoxDimension);
-
-    std::unordered_set<const maps::grid::TraversabilityNodeBase*> inRobot;
-    std::unordered_set<const maps::grid::TraversabilityNodeBase*> inBoundary;
+    return isPathFeasible(path.front(), makeFootprint(path, poses, trMap, config));
+}
 
-    for(size_t i = 0; i < path.size(); i++)
+bool ugv_nav4d::PathStatistic::isPathFeasible(const traversability_generator3d::TravGenNode* startNode, const SweptFootprint& footprint)
+{
+    bool hasObstacle = false;
+    walkFootprint(startNode, footprint, footprintNodes, [&] (const SweptFootprint::Cell &cell, const traversability_generator3d::TravGenNode *node, bool &stop)
     {
-        const traversability_generator3d::TravGenNode *node(path[i]);
-        const base::Pose2D curPose(poses[i]);
-
-        const Eigen::Rotation2D<double> yawInverse(Eigen::Rotation2D<double>(curPose.orientation).inverse());
-
-        maps::grid::Vector3d nodePos3 = node->getPosition(trMap);
-        const maps::grid::Vector2d nodePos(nodePos3.head<2>());
-
-        bool hasObstacle = false;
- 
-        node->eachConnectedNode([&] (const maps::grid::TraversabilityNodeBase *neighbor, bool &explandNode, bool &stop){
-            //we need to compute the four edges of a cell and check if any is inside of the robot
-            maps::grid::Vector3d neighborPos;
-            trMap.fromGrid(neighbor->getIndex(), neighborPos, neighbor->getHeight(), false);
-            
-            bool isInsideRobot = false;
-            bool isInsideOuterBox = false;
-            
-            for(const Eigen::Vector2d &ep : edgePositions)
-            {
-                const Eigen::Vector2d edgePos(neighborPos.head<2>() + ep);
-                
-                //translate to center
-                Eigen::Vector2d tp = edgePos - curPose.position;
-                //rotate invers to orientation of robot
-                tp = yawInverse * tp;
-                
-                if(costFunctionBoundingBox.contains(tp))
-                {
-                    isInsideOuterBox = true;
-                    
-                    //it is only inside the robot
-                    if(robotBoundingBox.contains(tp))
-                    {
-                        isInsideRobot = true;
-                        break;
-                    }
-                }
-            }
-                
-            if(!isInsideOuterBox)
-            {
-                return;
-            }
-
-            //further expand node
-            explandNode = true;
-
-            if(isInsideRobot)
-            {
-               if(neighbor->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
-                {
-                    hasObstacle = true;
-                    stop = true;
-                }
-                
-                return;
-            }
-         
-        });
-        if(hasObstacle)
-            return false;
-    }
-    return true;
-}
\ No newline at end of file
+        if(cell.isInsideRobot() && node->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
+        {
+            hasObstacle = true;
+            stop = true;
+        }
+    });
+    return !hasObstacle;
+}
@@ -3,6 +3,8 @@
 #include <traversability_generator3d/TravGenNode.hpp>
 #include <traversability_generator3d/TraversabilityConfig.hpp>
 #include <base/Pose.hpp>
+#include "SweptFootprint.hpp"
+#include <array>
 
 namespace ugv_nav4d
 {
@@ -23,7 +25,7 @@ public:
         
         /** Minimum distance to each patch type.
          *  Indexed by patch type. */
-        std::vector<double> minDistance;
+        std::array<double, maps::grid::TraversabilityNodeBase::FRONTIER + 1> minDistance;
     public:
         Stats();
         
@@ -71,8 +73,19 @@ public:
     void calculateStatistics(const std::vector<const traversability_generator3d::TravGenNode*> &path, const std::vector<base::Pose2D> &poses, 
                              const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap, const std::string &debugObstacleName = std::string());
 
+    /**
+     * Same as above, but uses a precomputed footprint of the path (e.g. PreComputedMotions::getFootprint()).
+     * @param startNode Node of the start cell of @p footprint
+     */
+    void calculateStatistics(const traversability_generator3d::TravGenNode* startNode, const SweptFootprint &footprint,
+                             const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap, const std::string &debugObstacleName = std::string());
+
     bool isPathFeasible(const std::vector<const traversability_generator3d::TravGenNode*> &path, const std::vector<base::Pose2D> &poses, 
                              const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode *> &trMap);                             
+
+    /** @return false if any cell inside the robot is not traversable while following @p footprint.
+     *  @param startNode Node of the start cell of @p footprint */
+    bool isPathFeasible(const traversability_generator3d::TravGenNode* startNode, const SweptFootprint &footprint);
     
     const Stats &getRobotStats() const
     {
@@ -6,8 +6,10 @@
 #include <vizkit3d_debug_drawings/DebugDrawingColors.hpp>
 #include <base/Eigen.hpp>
 #include "PlannerDump.hpp"
+#include "ParallelSearch.hpp"
 #include <omp.h>
 #include <cmath>
+#include <algorithm>
 #include <base-logging/Logging.hpp>
 #include "Logger.hpp"
 
@@ -22,7 +24,8 @@ Planner::Planner(const sbpl_spline_primitives::SplinePrimitivesConfig& primitive
         const Mobility& mobility, const PlannerConfig& plannerConfig) :
     splinePrimitiveConfig(primitiveConfig),
     mobility(mobility),
-    plannerConfig(plannerConfig)
+    plannerConfig(plannerConfig),
+    previousStartPositions(traversabilityConfig.gridResolution, plannerConfig.maxPreviousStartPositions)
 {
     setTravConfig(traversabilityConfig);
 }
@@ -36,6 +39,13 @@ void Planner::setInitialPatch(const Eigen::Affine3d& body2Mls, double patchRadiu
     }
 }
 
+void Planner::setMotionCacheDirectory(const std::string& directory)
+{
+    if(env)
+        LOG_WARN_S << "Planner::setMotionCacheDirectory: the motions have already been computed, the cache is not used";
+    motionCacheDirectory = directory;
+}
+
 void Planner::enablePathStatistics(bool enable){
     if (env){
         env->enablePathStatistics(enable);
@@ -82,7 +92,9 @@ bool Planner::calculateGoal(const Eigen::Vector3d& start_translation, Eigen::Vec
                 return temp.z();
             }();
 
-            if(tryGoal(temp, yaw)) {
+            //candidates are only validated, the goal heuristic is computed for the accepted goal.
+            //It also rejects goals that cannot be reached, the search continues with the next candidate then.
+            if(tryGoal(temp, yaw, false) && computeHeuristic()) {
                 goal_translation = temp; // for future use by calling function
                 return true;
             }
@@ -118,14 +130,28 @@ bool Planner::calculateGoal(const Eigen::Vector3d& start_translation, Eigen::Vec
 }
 
 
-bool Planner::tryGoal(const Eigen::Vector3d& translation, const double yaw) noexcept
+bool Planner::tryGoal(const Eigen::Vector3d& translation, const double yaw, bool computeHeuristic) noexcept
+{
+    try
+    {
+        env->setGoal(translation, yaw, computeHeuristic);
+    }
+    catch(const std::runtime_error& ex)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Planner::computeHeuristic() noexcept
 {
     try
     {
-        env->setGoal(translation, yaw);
+        env->precomputeCost();
     }
     catch(const std::runtime_error& ex)
     {
+        LOG_INFO_S << "Failed to compute heuristic: " << ex.what();
         return false;
     }
     return true;
@@ -151,11 +177,6 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
 
     resultTrajectory2D.clear();
     resultTrajectory3D.clear();
-    env->clear();
-
-    if(!planner)
-        planner.reset(new ARAPlanner(env.get(), true));
-
 
     Eigen::Affine3d ground2Body(Eigen::Affine3d::Identity());
     ground2Body.translation() = Eigen::Vector3d(0, 0, -traversabilityConfig.distToGround);
@@ -175,15 +196,9 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
     startbody2Mls.setTransform(startGround2Mls);
     endbody2Mls.setTransform(endGround2Mls);
 
-    //TODO maybe use a deque and limit to last 30 starts?
-    previousStartPositions.push_back(startGround2Mls.translation());
-
-    env->expandMap(previousStartPositions);
-    if(travMapCallback)
-        travMapCallback();
     try
     {
-        env->setStart(startGround2Mls.translation(), base::getYaw(Eigen::Quaterniond(startGround2Mls.linear())));
+        initSearch(startGround2Mls);
     }
     catch(const ugv_nav4d::ObstacleCheckFailed& ex)
     {
@@ -209,6 +224,45 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
         return GOAL_INVALID;
     }
 
+    const PLANNING_RESULT result = searchPath(maxTime, start_translation, goal_translation, end_pose.getYaw(), ground2Body,
+                                              resultTrajectory2D, resultTrajectory3D);
+    if(result == NO_SOLUTION && dumpOnError)
+        PlannerDump dump(*this, "no_solution", maxTime, startbody2Mls, endbody2Mls);
+    if(result == FOUND_SOLUTION && dumpOnSuccess)
+        PlannerDump dump(*this, "success", maxTime, startbody2Mls, endbody2Mls);
+
+    return result;
+}
+
+void Planner::initSearch(const Eigen::Affine3d& startGround2Mls)
+{
+    previousStartPositions.add(startGround2Mls.translation());
+
+    //expanding the map outdates the search graph, thus it has to happen before the graph is cleared
+    env->expandMap(previousStartPositions.getPositions());
+    if(travMapCallback)
+        travMapCallback();
+
+    if(plannerConfig.incrementalReplanning)
+        env->clearForReplanning(plannerConfig.maxReplanningStates);
+    else
+        env->clear();
+    env->setParallelHeuristic(plannerConfig.parallelHeuristic, plannerConfig.deltaSteppingBucketWidth);
+    env->enableLazyHeuristic(plannerConfig.lazyHeuristic);
+    //the start heuristic is only used by backward searches
+    env->setStartHeuristicRequired(!forwardSearch);
+
+    if(!planner)
+        planner.reset(new ARAPlanner(env.get(), forwardSearch));
+
+    env->setStart(startGround2Mls.translation(), base::getYaw(Eigen::Quaterniond(startGround2Mls.linear())));
+}
+
+Planner::PLANNING_RESULT Planner::searchPath(const base::Time& maxTime, const Eigen::Vector3d& start_translation,
+                                             const Eigen::Vector3d& goal_translation, double goalYaw, const Eigen::Affine3d& ground2Body,
+                                             std::vector<SubTrajectory>& resultTrajectory2D,
+                                             std::vector<SubTrajectory>& resultTrajectory3D)
+{
     //this has to happen after env->setStart and env->setGoal because those methods initialize the
     //StateID2IndexMapping which is accessed inside force_planning_from_scratch_and_free_memory().
     try
@@ -229,6 +283,24 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
         LOG_ERROR_S << "InitializeMDPCfg failed, start and goal id cannot be requested yet";
         return INTERNAL_ERROR;
     }
+
+    if(plannerConfig.useParallelSearch)
+    {
+        const unsigned batchSize = plannerConfig.parallelSearchBatchSize > 0 ?
+                                   plannerConfig.parallelSearchBatchSize : std::max(plannerConfig.numThreads, 1u);
+        ParallelSearch search(*env, batchSize);
+        if(!search.search(mdp_cfg.startstateid, mdp_cfg.goalstateid, plannerConfig.initialEpsilon,
+                          maxTime.toSeconds(), solutionIds))
+        {
+            LOG_INFO_S << "num expands: " << search.getNumExpands();
+            return NO_SOLUTION;
+        }
+        LOG_INFO_S << "num expands: " << search.getNumExpands() << ", cost: " << search.getSolutionCost();
+
+        env->getTrajectories(solutionIds, &resultTrajectory2D, &resultTrajectory3D, start_translation, goal_translation, goalYaw, ground2Body);
+        return FOUND_SOLUTION;
+    }
+
     if (planner->set_start(mdp_cfg.startstateid) == 0) {
         LOG_ERROR_S << "Failed to set start state";
         return INTERNAL_ERROR;
@@ -248,8 +320,6 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
         if(!planner->replan(maxTime.toSeconds(), &solutionIds))
         {
             LOG_INFO_S << "num expands: " << planner->get_n_expands();
-            if(dumpOnError)
-                PlannerDump dump(*this, "no_solution", maxTime, startbody2Mls, endbody2Mls);
             return NO_SOLUTION;
         }
 
@@ -266,24 +336,200 @@ Planner::PLANNING_RESULT Planner::plan(const base::Time& maxTime, const base::sa
             LOG_INFO_S << "cost " << s.cost << " time " << s.time << "num childs " << s.expands;
         }
 
-        env->getTrajectory(solutionIds, resultTrajectory2D, true, start_translation, goal_translation, end_pose.getYaw(), ground2Body);
-        env->getTrajectory(solutionIds, resultTrajectory3D, false, start_translation, goal_translation,end_pose.getYaw(), ground2Body);
+        env->getTrajectories(solutionIds, &resultTrajectory2D, &resultTrajectory3D, start_translation, goal_translation, goalYaw, ground2Body);
     }
     catch(const SBPL_Exception& ex)
     {
         LOG_ERROR_S << "caught sbpl exception: " << ex.what();
-        LOG_ERROR_S << "dumping state";
-        if(dumpOnError)
-            PlannerDump dump(*this, "no_solution", maxTime, startbody2Mls, endbody2Mls);
         return NO_SOLUTION;
     }
 
-    if(dumpOnSuccess)
-        PlannerDump dump(*this, "success", maxTime, startbody2Mls, endbody2Mls);
+    return FOUND_SOLUTION;
+}
 
+
+std::vector<Planner::GoalResult> Planner::planToGoals(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                                      const std::vector<base::samples::RigidBodyState>& goal_poses, bool planTrajectories)
+{
+    std::vector<GoalResult> results(goal_poses.size());
+    if(!estimateGoalCosts(start_pose, goal_poses, results) || !planTrajectories)
+        return results;
+
+    for(size_t i = 0; i < goal_poses.size(); ++i)
+    {
+        if(results[i].result == FOUND_SOLUTION)
+            results[i].result = planToEstimatedGoal(maxTime, start_pose, goal_poses[i], results[i]);
+    }
+    return results;
+}
+
+Planner::PLANNING_RESULT Planner::planToNearestGoal(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                                    const std::vector<base::samples::RigidBodyState>& goal_poses, size_t& goalIndex,
+                                                    std::vector<SubTrajectory>& resultTrajectory2D,
+                                                    std::vector<SubTrajectory>& resultTrajectory3D)
+{
+    resultTrajectory2D.clear();
+    resultTrajectory3D.clear();
+    if(!env)
+    {
+        LOG_ERROR_S << "Planner::planToNearestGoal : Error : No map was set";
+        return NO_MAP;
+    }
+
+    std::vector<GoalResult> results(goal_poses.size());
+    if(!estimateGoalCosts(start_pose, goal_poses, results))
+        return START_INVALID;
+
+    std::vector<size_t> order;
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        if(results[i].result == FOUND_SOLUTION)
+            order.push_back(i);
+    }
+    if(order.empty())
+        return GOAL_INVALID;
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        return results[a].estimatedCost < results[b].estimatedCost;
+    });
+
+    //the estimate is a lower bound of the travel time of every trajectory to the goal. Once it is not
+    //below the cheapest trajectory found so far, none of the remaining goals can be cheaper
+    size_t best = results.size();
+    std::vector<int> bestSolutionIds;
+    for(size_t i : order)
+    {
+        if(best < results.size() && results[i].estimatedCost >= results[best].cost)
+            break;
+
+        if(planToEstimatedGoal(maxTime, start_pose, goal_poses[i], results[i]) == FOUND_SOLUTION &&
+           (best == results.size() || results[i].cost < results[best].cost))
+        {
+            best = i;
+            bestSolutionIds = solutionIds;
+        }
+    }
+    if(best == results.size())
+        return NO_SOLUTION;
+
+    //getSolutionCost() and getMotions() refer to the returned trajectory
+    solutionIds.swap(bestSolutionIds);
+    goalIndex = best;
+    resultTrajectory2D.swap(results[best].trajectory2D);
+    resultTrajectory3D.swap(results[best].trajectory3D);
     return FOUND_SOLUTION;
 }
 
+bool Planner::estimateGoalCosts(const base::samples::RigidBodyState& start_pose,
+                                const std::vector<base::samples::RigidBodyState>& goal_poses, std::vector<GoalResult>& results)
+{
+    omp_set_num_threads(plannerConfig.numThreads);
+    if(!env)
+    {
+        LOG_ERROR_S << "Planner::planToGoals : Error : No map was set";
+        for(GoalResult& result : results)
+            result.result = NO_MAP;
+        return false;
+    }
+
+    Eigen::Affine3d ground2Body(Eigen::Affine3d::Identity());
+    ground2Body.translation() = Eigen::Vector3d(0, 0, -traversabilityConfig.distToGround);
+
+    try
+    {
+        initSearch(start_pose.getTransform() * ground2Body);
+    }
+    catch(const std::runtime_error& ex)
+    {
+        LOG_INFO_S << "Invalid start: " << ex.what();
+        for(GoalResult& result : results)
+            result.result = START_INVALID;
+        return false;
+    }
+
+    //the estimates are read from the distance field of the start. It is computed once and
+    //is used to validate all goals as well
+    env->setStartHeuristicRequired(true);
+    for(size_t i = 0; i < goal_poses.size(); ++i)
+    {
+        const Eigen::Affine3d goalGround2Mls(goal_poses[i].getTransform() * ground2Body);
+        Eigen::Vector3d goal_translation = goalGround2Mls.translation();
+        double z;
+        if(env->getMlsMap().getClosestSurfacePos(goal_translation, z))
+            goal_translation.z() = z;
+
+        if(!tryGoal(goal_translation, base::getYaw(Eigen::Quaterniond(goalGround2Mls.linear())), false))
+        {
+            results[i].result = GOAL_INVALID;
+            continue;
+        }
+
+        MDPConfig mdp_cfg;
+        if(!env->InitializeMDPCfg(&mdp_cfg))
+        {
+            results[i].result = INTERNAL_ERROR;
+            continue;
+        }
+        results[i].estimatedCost = env->GetStartHeuristic(mdp_cfg.goalstateid) / Motion::costScaleFactor;
+        results[i].result = FOUND_SOLUTION;
+    }
+    return true;
+}
+
+Planner::PLANNING_RESULT Planner::planToEstimatedGoal(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                                      const base::samples::RigidBodyState& goal_pose, GoalResult& result)
+{
+    Eigen::Affine3d ground2Body(Eigen::Affine3d::Identity());
+    ground2Body.translation() = Eigen::Vector3d(0, 0, -traversabilityConfig.distToGround);
+
+    const Eigen::Affine3d startGround2Mls(start_pose.getTransform() * ground2Body);
+    const Eigen::Affine3d goalGround2Mls(goal_pose.getTransform() * ground2Body);
+
+    //the start state is still set, only the goal and its heuristic change
+    Eigen::Vector3d goal_translation = goalGround2Mls.translation();
+    if(!calculateGoal(startGround2Mls.translation(), goal_translation, base::getYaw(Eigen::Quaterniond(goalGround2Mls.linear()))))
+        return GOAL_INVALID;
+
+    const PLANNING_RESULT planningResult = searchPath(maxTime, startGround2Mls.translation(), goal_translation, goal_pose.getYaw(),
+                                                      ground2Body, result.trajectory2D, result.trajectory3D);
+    if(planningResult == FOUND_SOLUTION)
+        result.cost = getSolutionCost();
+    return planningResult;
+}
+
+Planner::PLANNING_RESULT Planner::computeTravelTimes(const base::samples::RigidBodyState& start_pose, std::vector<double>& travelTimes)
+{
+    travelTimes.clear();
+    omp_set_num_threads(plannerConfig.numThreads);
+    if(!env)
+    {
+        LOG_ERROR_S << "Planner::computeTravelTimes : Error : No map was set";
+        return NO_MAP;
+    }
+
+    Eigen::Affine3d ground2Body(Eigen::Affine3d::Identity());
+    ground2Body.translation() = Eigen::Vector3d(0, 0, -traversabilityConfig.distToGround);
+
+    try
+    {
+        initSearch(start_pose.getTransform() * ground2Body);
+    }
+    catch(const std::runtime_error& ex)
+    {
+        LOG_INFO_S << "Invalid start: " << ex.what();
+        return START_INVALID;
+    }
+
+    env->getTravelTimesFromStart(travelTimes);
+    return FOUND_SOLUTION;
+}
+
+double Planner::getSolutionCost() const
+{
+    return env->getPathCost(solutionIds) / Motion::costScaleFactor;
+}
+
 std::vector< Motion > Planner::getMotions() const
 {
     return env->getMotions(solutionIds);
@@ -321,6 +567,10 @@ void Planner::setTravConfig(const traversability_generator3d::TraversabilityConf
     if(config.gridResolution != splinePrimitiveConfig.gridSize)
         throw std::runtime_error("Planner::Planner : Configuration error, grid resolution of Primitives and TraversabilityGenerator3d differ");
 
+    //the start positions are deduplicated on cells of the old resolution
+    if(config.gridResolution != traversabilityConfig.gridResolution)
+        previousStartPositions.setCellSize(config.gridResolution);
+
     traversabilityConfig = config;
     if(env){
         env->setTravConfig(config);
@@ -330,6 +580,7 @@ void Planner::setTravConfig(const traversability_generator3d::TraversabilityConf
  void Planner::setPlannerConfig(const PlannerConfig& config)
  {
      plannerConfig = config;
+     previousStartPositions.setCapacity(plannerConfig.maxPreviousStartPositions);
  }
 
 }
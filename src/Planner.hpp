@@ -5,7 +5,9 @@
 #include "EnvironmentXYZTheta.hpp"
 #include <trajectory_follower/SubTrajectory.hpp>
 #include "PlannerConfig.hpp"
+#include "StartPositionHistory.hpp"
 
+#include <limits>
 #include <memory>
 
 class ARAPlanner;
@@ -31,8 +33,14 @@ protected:
     
     std::function<void ()> travMapCallback;
     
+    /** Search direction of the ARA* planner */
+    static constexpr bool forwardSearch = true;
+
     /**are buffered and reused for a more robust map generation */
-    std::vector<Eigen::Vector3d> previousStartPositions;
+    StartPositionHistory previousStartPositions;
+
+    /** See setMotionCacheDirectory() */
+    std::string motionCacheDirectory;
     
 public:
     enum PLANNING_RESULT {
@@ -43,42 +51,97 @@ public:
         INTERNAL_ERROR,
         FOUND_SOLUTION,
     };
+
+    /** Result of one goal of planToGoals() */
+    struct GoalResult
+    {
+        /** FOUND_SOLUTION if the goal is valid and reachable. If trajectories have been planned,
+         *  FOUND_SOLUTION means that a trajectory has been found. */
+        PLANNING_RESULT result = GOAL_INVALID;
+        /** Estimated travel time (in seconds) from the start to the goal along the traversability map.
+         *  This is the start heuristic of the goal, it ignores the motion primitives. */
+        double estimatedCost = std::numeric_limits<double>::infinity();
+        /** Travel time (in seconds) of the planned trajectory. Only set if trajectories have been planned */
+        double cost = std::numeric_limits<double>::infinity();
+        std::vector<trajectory_follower::SubTrajectory> trajectory2D;
+        std::vector<trajectory_follower::SubTrajectory> trajectory3D;
+    };
     
     Planner(const sbpl_spline_primitives::SplinePrimitivesConfig &primitiveConfig, 
         const traversability_generator3d::TraversabilityConfig &traversabilityConfig,
         const Mobility& mobility, 
         const PlannerConfig& plannerConfig);
     
+    /** Copies @p mls into the planner */
     template <maps::grid::MLSConfig::update_model SurfacePatch>
     void updateMap(const maps::grid::MLSMap<SurfacePatch>& mls)
     {
-        std::shared_ptr<MLSBase> mlsPtr = std::make_shared<MLSBase>(mls);
+        updateMap(std::make_shared<const MLSBase>(mls));
+    }
+    
+    /** Copies @p mls into the planner */
+    void updateMap(const MLSBase &mls)
+    {
+        updateMap(std::make_shared<const MLSBase>(mls));
+    }
+
+    /** Moves @p mls into the planner */
+    void updateMap(MLSBase &&mls)
+    {
+        updateMap(std::make_shared<const MLSBase>(std::move(mls)));
+    }
 
+    /** Hands @p mls to the planner without copying it.
+     *  The planner only reads the map and keeps a reference to it until the next update.
+     *  The caller must not modify the map afterwards (copy-on-write): to change it, copy it,
+     *  modify the copy and hand over the copy. Thus a mapping thread can share its map
+     *  with the planner as long as it does not update it in place. */
+    void updateMap(std::shared_ptr<const MLSBase> mls)
+    {
         if(!env)
         {
-            env.reset(new EnvironmentXYZTheta(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility));
+            env.reset(new EnvironmentXYZTheta(mls, traversabilityConfig, splinePrimitiveConfig, mobility, motionCacheDirectory));
         }
         else
         {
-            env->updateMap(mlsPtr);
+            env->updateMap(mls);
         }
     }
-    
-    void updateMap(const MLSBase &mls)
+
+    /** Updates the map, assuming that only the cells inside @p changedRegion (map frame) changed.
+     *  The traversability map and the search graph outside of the region are kept.
+     *  See EnvironmentXYZTheta::updateMap() */
+    template <maps::grid::MLSConfig::update_model SurfacePatch>
+    void updateMap(const maps::grid::MLSMap<SurfacePatch>& mls, const Eigen::AlignedBox3d& changedRegion)
+    {
+        updateMap(std::make_shared<const MLSBase>(mls), changedRegion);
+    }
+
+    void updateMap(const MLSBase &mls, const Eigen::AlignedBox3d& changedRegion)
     {
-        std::shared_ptr<MLSBase> mlsPtr= std::make_shared<MLSBase>(mls);
+        updateMap(std::make_shared<const MLSBase>(mls), changedRegion);
+    }
 
+    /** Same as updateMap(std::shared_ptr<const MLSBase>), but only the cells inside @p changedRegion changed */
+    void updateMap(std::shared_ptr<const MLSBase> mls, const Eigen::AlignedBox3d& changedRegion)
+    {
         if(!env)
         {
-            env.reset(new EnvironmentXYZTheta(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility));
+            env.reset(new EnvironmentXYZTheta(mls, traversabilityConfig, splinePrimitiveConfig, mobility, motionCacheDirectory));
         }
         else
         {
-            env->updateMap(mlsPtr);
+            env->updateMap(mls, changedRegion);
         }
     }
+
     void setInitialPatch(const Eigen::Affine3d& body2Mls, double patchRadius);
 
+    /** Motion primitives are cached in @p directory. Computing the primitives can take seconds,
+     *  loading them from the cache takes milliseconds. An empty string disables the cache (default).
+     *  Needs to be called before the first map is set. */
+    void setMotionCacheDirectory(const std::string& directory);
+
     void enablePathStatistics(bool enable);
 
     /**
@@ -97,7 +160,8 @@ public:
      *  (in addition to the current start position) to try to expand the map. Thus even if the current start
      *  position is invalid (e.g. inside an obstacle) the map will still be expanded based on the previous start
      *  positions. This feature improves the general robustness during planning and generally results in more
-     *  complete maps under real-world conditions.
+     *  complete maps under real-world conditions. The number of remembered positions is bounded by
+     *  PlannerConfig::maxPreviousStartPositions.
      * 
      * @param maxTime Maximum processor time to use.
      * @param startbody2Mls The start position of the body in mls coordinates. This should be the location of the body-frame.
@@ -126,6 +190,46 @@ public:
                          const base::samples::RigidBodyState& end_pose, std::vector<trajectory_follower::SubTrajectory>& resultTrajectory2D,
                          std::vector<trajectory_follower::SubTrajectory>& resultTrajectory3D, bool dumpOnError = false, bool dumpOnSuccess = false);
    
+    /** Evaluates many goals for one start.
+     *
+     *  The map is expanded and the start is set only once. One distance field is computed from the start
+     *  and shared by all goals. It rejects invalid and unreachable goals and yields the estimated cost of
+     *  every goal, which is enough to rank the goals.
+     *  If @p planTrajectories is true, a trajectory is planned to every reachable goal as well. All searches
+     *  share the search graph and the obstacle checks of the motions.
+     *
+     *  The poses are interpreted like in plan(). Goals are not moved by Mobility::searchRadius
+     *  for the estimation, but they are when planning the trajectories.
+     * @param maxTime Maximum processor time per planned trajectory.
+     * @return One result per entry of @p goal_poses */
+    std::vector<GoalResult> planToGoals(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                        const std::vector<base::samples::RigidBodyState>& goal_poses, bool planTrajectories = false);
+
+    /** Plans to the goal of @p goal_poses that is the cheapest to reach.
+     *
+     *  The goals are ranked by their estimated cost (see planToGoals()). Trajectories are planned
+     *  in that order until the estimated cost of the next goal is not below the cost of the cheapest
+     *  trajectory found so far. The estimate is a lower bound, thus no remaining goal can be cheaper.
+     *  The cost is the one of the planned trajectories, which depends on PlannerConfig::initialEpsilon.
+     * @param goalIndex Index of the reached goal in @p goal_poses. Only valid if FOUND_SOLUTION is returned.
+     * @param maxTime Maximum processor time per goal that is tried. */
+    PLANNING_RESULT planToNearestGoal(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                      const std::vector<base::samples::RigidBodyState>& goal_poses, size_t& goalIndex,
+                                      std::vector<trajectory_follower::SubTrajectory>& resultTrajectory2D,
+                                      std::vector<trajectory_follower::SubTrajectory>& resultTrajectory3D);
+
+    /** Computes the travel time (in seconds) from @p start_pose to every patch of the traversability map.
+     *
+     *  Uses the distance field of the heuristic, thus it is much cheaper than planning, but
+     *  the motion primitives are ignored. The map is expanded from the start like in plan().
+     * @param travelTimes Indexed by the id of the TravGenNodes of getTraversabilityMap() (getUserData().id).
+     *                    Unreachable patches are infinity.
+     * @return FOUND_SOLUTION on success, NO_MAP or START_INVALID otherwise */
+    PLANNING_RESULT computeTravelTimes(const base::samples::RigidBodyState& start_pose, std::vector<double>& travelTimes);
+
+    /** @return the travel time (in seconds) of the last planned trajectory */
+    double getSolutionCost() const;
+
     void setTravConfig(const traversability_generator3d::TraversabilityConfig& config);
     
     void setPlannerConfig(const PlannerConfig& config);
@@ -139,7 +243,28 @@ public:
 
     private:
     bool calculateGoal(const Eigen::Vector3d& start_translation, Eigen::Vector3d& goal_translation, const double yaw) noexcept;
-    bool tryGoal(const Eigen::Vector3d& translation, const double yaw) noexcept;
+    /** @param computeHeuristic If false the goal is only validated, see EnvironmentXYZTheta::setGoal() */
+    bool tryGoal(const Eigen::Vector3d& translation, const double yaw, bool computeHeuristic = true) noexcept;
+    bool computeHeuristic() noexcept;
+
+    /** Resets the search, expands the map around the start and sets the start state.
+     *  @throw the exceptions of EnvironmentXYZTheta::setStart() */
+    void initSearch(const Eigen::Affine3d& startGround2Mls);
+
+    /** Searches from the current start state to the current goal state and generates the trajectories */
+    PLANNING_RESULT searchPath(const base::Time& maxTime, const Eigen::Vector3d& start_translation,
+                               const Eigen::Vector3d& goal_translation, double goalYaw, const Eigen::Affine3d& ground2Body,
+                               std::vector<trajectory_follower::SubTrajectory>& resultTrajectory2D,
+                               std::vector<trajectory_follower::SubTrajectory>& resultTrajectory3D);
+
+    /** Sets the start and estimates the costs of all goals, see planToGoals().
+     *  @return false if the start is invalid or there is no map, all results are set accordingly */
+    bool estimateGoalCosts(const base::samples::RigidBodyState& start_pose,
+                           const std::vector<base::samples::RigidBodyState>& goal_poses, std::vector<GoalResult>& results);
+
+    /** Plans a trajectory to @p goal_pose after estimateGoalCosts(), reusing its search graph */
+    PLANNING_RESULT planToEstimatedGoal(const base::Time& maxTime, const base::samples::RigidBodyState& start_pose,
+                                        const base::samples::RigidBodyState& goal_pose, GoalResult& result);
 
 };
 
@@ -20,5 +20,33 @@ struct PlannerConfig
     double epsilonSteps = 2.0;
     /** Number of threads to use during planning */
     unsigned numThreads = 1;
+    /** Compute the distance fields of the heuristic using a parallel delta-stepping
+     *  shortest path algorithm with numThreads threads. Only useful for very large maps.
+     *  If false the start and goal field are computed concurrently on two threads. */
+    bool parallelHeuristic = false;
+    /** Bucket width (in meter) of the delta-stepping algorithm used if parallelHeuristic is true */
+    double deltaSteppingBucketWidth = 3.0;
+    /** Compute the goal heuristic on demand using a resumable backward search from the goal
+     *  instead of precomputing it for the whole map. Keeps short range queries cheap on large maps. */
+    bool lazyHeuristic = false;
+    /** Use a weighted A* that expands batches of states in parallel instead of ARA*.
+     *  The heuristic is inflated by initialEpsilon. No anytime improvement is done. */
+    bool useParallelSearch = false;
+    /** Number of states that are expanded concurrently by the parallel search.
+     *  0 means numThreads */
+    unsigned parallelSearchBatchSize = 0;
+    /** Keep the search graph between calls to plan() as long as the map does not change.
+     *  The states of previous plans are reused and the goal heuristic is reused if the goal
+     *  did not change. Useful for high frequency replanning where only the start moves.
+     *  Applies to ARA* and the parallel search, both only keep the states, the goal heuristic
+     *  and the obstacle checks of the motions. Successors are generated again by every search. */
+    bool incrementalReplanning = false;
+    /** Maximum number of states kept by incrementalReplanning. If the previous searches created
+     *  more states, the search graph is dropped before the next plan. 0 means unbounded. */
+    unsigned maxReplanningStates = 2000000;
+    /** Maximum number of previous start positions that are used to expand the map.
+     *  Only the latest start inside each traversability grid cell is kept, if there are more
+     *  cells the least recently used one is dropped. 0 means unbounded. */
+    unsigned maxPreviousStartPositions = 30;
 };
 }
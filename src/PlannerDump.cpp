@@ -6,14 +6,61 @@
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <base-logging/Logging.hpp>
 
+/** Bump if the layout of the dump changes. The configs are written byte wise,
+ *  thus their sizes are stored as well to detect dumps of older versions */
+static const uint32_t dumpVersion = 1;
+static const char dumpMagic[8] = {'U', 'G', 'V', 'D', 'U', 'M', 'P', '\0'};
+
+namespace
+{
+struct DumpHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t traversabilityConfigSize;
+    uint32_t mobilitySize;
+    uint32_t splinePrimitiveConfigSize;
+    uint32_t plannerConfigSize;
+
+    DumpHeader() : version(dumpVersion),
+        traversabilityConfigSize(sizeof(traversability_generator3d::TraversabilityConfig)),
+        mobilitySize(sizeof(ugv_nav4d::Mobility)),
+        splinePrimitiveConfigSize(sizeof(sbpl_spline_primitives::SplinePrimitivesConfig)),
+        plannerConfigSize(sizeof(ugv_nav4d::PlannerConfig))
+    {
+        std::memcpy(magic, dumpMagic, sizeof(magic));
+    }
+
+    bool operator==(const DumpHeader& other) const
+    {
+        return std::memcmp(magic, other.magic, sizeof(magic)) == 0 && version == other.version &&
+               traversabilityConfigSize == other.traversabilityConfigSize &&
+               mobilitySize == other.mobilitySize &&
+               splinePrimitiveConfigSize == other.splinePrimitiveConfigSize &&
+               plannerConfigSize == other.plannerConfigSize;
+    }
+};
+}
+
 ugv_nav4d::PlannerDump::PlannerDump(const std::string& dumpName)
 {
     LOG_INFO_S << "Loading Dump " << dumpName;
     
     std::ifstream input(dumpName, std::ios::binary | std::ios::in);
-    
+    if(!input.is_open())
+        throw std::runtime_error("PlannerDump: Cannot open dump " + dumpName);
+
+    const DumpHeader expectedHeader;
+    DumpHeader header;
+    READ(header);
+    if(!input || !(header == expectedHeader))
+        throw std::runtime_error("PlannerDump: " + dumpName + " has been written by a different version of the planner");
+
     READ(traversabilityConfig);
     READ(mobility);
     READ(splinePrimitiveConfig);
@@ -36,6 +83,8 @@ ugv_nav4d::PlannerDump::PlannerDump(const ugv_nav4d::Planner& planner, const std
     LOG_INFO_S << "Dumping planner state to: " << targetFile;
     std::ofstream output(targetFile, std::ios::binary | std::ios::out|std::ios::trunc);
 
+    const DumpHeader header;
+    WRITE(header);
     WRITE(planner.traversabilityConfig);
     WRITE(planner.mobility);
     WRITE(planner.splinePrimitiveConfig);
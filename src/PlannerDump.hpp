@@ -30,6 +30,8 @@ public:
     
     /**
      * Constructor for loading
+     * @throw std::runtime_error if the dump cannot be opened or has been written by a
+     *        version with a different config layout
      * */
     PlannerDump(const std::string &dumpName);
 
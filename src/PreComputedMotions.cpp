@@ -1,6 +1,13 @@
 #include "PreComputedMotions.hpp"
 #include <maps/grid/GridMap.hpp>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unistd.h>
 #include <base/Angle.hpp>
 #include <base-logging/Logging.hpp>
 
@@ -9,9 +16,114 @@ namespace ugv_nav4d
 using namespace sbpl_spline_primitives;
 
 
+/** Bump if the layout of the cache files or the way motions are computed changes */
+static const uint32_t cacheVersion = 1;
+static const char cacheMagic[8] = {'U', 'G', 'V', 'M', 'O', 'T', 'N', '\0'};
+
+template <class T>
+static void appendBytes(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/** Bounds checked reading of a cache file that is completely loaded into memory */
+class CacheReader
+{
+    const char* pos;
+    const char* end;
+public:
+    CacheReader(const std::vector<char>& data) : pos(data.data()), end(data.data() + data.size())
+    {
+    }
+
+    template <class T>
+    bool read(T& value)
+    {
+        if(end - pos < static_cast<std::ptrdiff_t>(sizeof(T)))
+            return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value, size_t size)
+    {
+        if(static_cast<size_t>(end - pos) < size)
+            return false;
+        value.assign(pos, size);
+        pos += size;
+        return true;
+    }
+
+    bool read(base::Pose2D& pose)
+    {
+        return read(pose.position.x()) && read(pose.position.y()) && read(pose.orientation);
+    }
+
+    bool read(maps::grid::Index& cell)
+    {
+        return read(cell.x()) && read(cell.y());
+    }
+
+    bool read(PoseWithCell& step)
+    {
+        return read(step.pose) && read(step.cell);
+    }
+
+    /** @return false if there is not enough data left for @p numElements of at least @p minSize bytes.
+     *  Protects against huge allocations caused by damaged files */
+    bool canHold(uint64_t numElements, size_t minSize) const
+    {
+        return numElements <= static_cast<uint64_t>(end - pos) / minSize;
+    }
+
+    bool atEnd() const
+    {
+        return pos == end;
+    }
+};
+
+static void writePose(std::ostream& out, const base::Pose2D& pose)
+{
+    out.write(reinterpret_cast<const char*>(&pose.position.x()), sizeof(double));
+    out.write(reinterpret_cast<const char*>(&pose.position.y()), sizeof(double));
+    out.write(reinterpret_cast<const char*>(&pose.orientation), sizeof(double));
+}
+
+template <class T>
+static void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeSteps(std::ostream& out, const std::vector<PoseWithCell>& steps)
+{
+    writeValue<uint64_t>(out, steps.size());
+    for(const PoseWithCell& step : steps)
+    {
+        writePose(out, step.pose);
+        writeValue(out, step.cell.x());
+        writeValue(out, step.cell.y());
+    }
+}
+
+static bool readSteps(CacheReader& reader, std::vector<PoseWithCell>& steps)
+{
+    uint64_t numSteps;
+    if(!reader.read(numSteps) || !reader.canHold(numSteps, 3 * sizeof(double) + 2 * sizeof(int)))
+        return false;
+    steps.resize(numSteps);
+    for(PoseWithCell& step : steps)
+    {
+        if(!reader.read(step))
+            return false;
+    }
+    return true;
+}
+
 PreComputedMotions::PreComputedMotions(const SplinePrimitivesConfig& primitiveConfig,
                                        const Mobility& mobilityConfig):
-    primitives(primitiveConfig),
+    primitiveConfig(primitiveConfig),
     mobilityConfig(mobilityConfig)
 {
 }
@@ -19,13 +131,197 @@ PreComputedMotions::PreComputedMotions(const SplinePrimitivesConfig& primitiveCo
 
 void PreComputedMotions::computeMotions(double obstGridResolution, double travGridResolution)
 {
-    if(fabs(primitives.getConfig().gridSize - travGridResolution) > 1E-5)
+    if(fabs(primitiveConfig.gridSize - travGridResolution) > 1E-5)
     {
         LOG_ERROR_S << "PreComputedMotions::computeMotions: Error grid size and trav size do not match";
         throw std::runtime_error("PreComputedMotions::computeMotions: Error grid size and trav size do not match");
     }
 
-    readMotionPrimitives(primitives, mobilityConfig, obstGridResolution, travGridResolution);
+    if(cacheDirectory.empty())
+    {
+        readMotionPrimitives(getPrimitives(), mobilityConfig, obstGridResolution, travGridResolution);
+        return;
+    }
+
+    const std::string key = getCacheKey(obstGridResolution, travGridResolution);
+    std::ostringstream fileName;
+    fileName << cacheDirectory << "/ugv_nav4d_motions_" << std::hex << std::hash<std::string>()(key) << ".bin";
+
+    if(readCache(fileName.str(), key))
+    {
+        LOG_INFO_S << "Loaded " << idToMotion.size() << " motions from " << fileName.str();
+        return;
+    }
+
+    readMotionPrimitives(getPrimitives(), mobilityConfig, obstGridResolution, travGridResolution);
+    writeCache(fileName.str(), key);
+}
+
+void PreComputedMotions::setCacheDirectory(const std::string& directory)
+{
+    cacheDirectory = directory;
+}
+
+std::string PreComputedMotions::getCacheKey(double obstGridResolution, double travGridResolution) const
+{
+    std::string key;
+    appendBytes(key, cacheVersion);
+    appendBytes(key, Motion::costScaleFactor);
+    appendBytes(key, obstGridResolution);
+    appendBytes(key, travGridResolution);
+    //the config is a plain struct, it is written byte wise like in PlannerDump
+    appendBytes(key, primitiveConfig);
+    //Mobility contains padding, thus the members are added one by one
+    appendBytes(key, mobilityConfig.translationSpeed);
+    appendBytes(key, mobilityConfig.rotationSpeed);
+    appendBytes(key, mobilityConfig.minTurningRadius);
+    appendBytes(key, mobilityConfig.spline_sampling_resolution);
+    appendBytes(key, mobilityConfig.multiplierForward);
+    appendBytes(key, mobilityConfig.multiplierBackward);
+    appendBytes(key, mobilityConfig.multiplierLateral);
+    appendBytes(key, mobilityConfig.multiplierForwardTurn);
+    appendBytes(key, mobilityConfig.multiplierBackwardTurn);
+    appendBytes(key, mobilityConfig.multiplierPointTurn);
+    appendBytes(key, mobilityConfig.multiplierLateralCurve);
+    appendBytes(key, mobilityConfig.maxMotionCurveLength);
+    return key;
+}
+
+bool PreComputedMotions::readCache(const std::string& file, const std::string& key)
+{
+    std::ifstream input(file, std::ios::binary | std::ios::ate);
+    if(!input.is_open())
+        return false;
+
+    std::vector<char> data(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    if(!input.read(data.data(), data.size()))
+        return false;
+
+    CacheReader reader(data);
+    char magic[sizeof(cacheMagic)];
+    uint64_t keySize;
+    std::string fileKey;
+    if(!reader.read(magic) || std::memcmp(magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+       !reader.read(keySize) || !reader.read(fileKey, keySize) || fileKey != key)
+    {
+        LOG_WARN_S << "Ignoring motion cache " << file << ", it has been written for a different configuration";
+        return false;
+    }
+
+    const int numAngles = primitiveConfig.numAngles;
+    uint64_t numMotions;
+    if(!reader.read(numMotions))
+        return false;
+
+    std::vector<Motion> motions;
+    for(uint64_t i = 0; i < numMotions; ++i)
+    {
+        Motion motion(numAngles);
+        int endTheta, startTheta, type;
+        uint64_t numSamples;
+        if(!reader.read(motion.xDiff) || !reader.read(motion.yDiff) || !reader.read(endTheta) ||
+           !reader.read(startTheta) || !reader.read(type) || !reader.read(motion.baseCost) ||
+           !reader.read(motion.costMultiplier) || !reader.read(motion.translationlDist) ||
+           !reader.read(motion.angularDist) || !readSteps(reader, motion.intermediateStepsTravMap) ||
+           !readSteps(reader, motion.intermediateStepsObstMap) || !reader.read(numSamples) ||
+           !reader.canHold(numSamples, 2 * sizeof(int) + sizeof(uint64_t)))
+        {
+            LOG_WARN_S << "Ignoring damaged motion cache " << file;
+            return false;
+        }
+        if(type < Motion::MOV_FORWARD || type > Motion::MOV_LATERAL)
+        {
+            LOG_WARN_S << "Ignoring damaged motion cache " << file << ", invalid motion type " << type;
+            return false;
+        }
+        motion.endTheta = DiscreteTheta(endTheta, numAngles);
+        motion.startTheta = DiscreteTheta(startTheta, numAngles);
+        motion.type = static_cast<Motion::Type>(type);
+
+        motion.fullSplineSamples.resize(numSamples);
+        for(CellWithPoses& sample : motion.fullSplineSamples)
+        {
+            uint64_t numPoses;
+            if(!reader.read(sample.cell) || !reader.read(numPoses) || !reader.canHold(numPoses, 3 * sizeof(double)))
+            {
+                LOG_WARN_S << "Ignoring damaged motion cache " << file;
+                return false;
+            }
+            sample.poses.resize(numPoses);
+            for(base::Pose2D& pose : sample.poses)
+                reader.read(pose);
+        }
+        motions.push_back(std::move(motion));
+    }
+
+    if(!reader.atEnd())
+    {
+        LOG_WARN_S << "Ignoring damaged motion cache " << file;
+        return false;
+    }
+
+    //the motions are stored in id order, thus they get the same ids again
+    for(const Motion& motion : motions)
+        setMotionForTheta(motion, motion.startTheta);
+    return true;
+}
+
+void PreComputedMotions::writeCache(const std::string& file, const std::string& key) const
+{
+    //write to a temporary file first, concurrent readers never see a partial cache
+    const std::string tmpFile = file + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream output(tmpFile, std::ios::binary | std::ios::trunc);
+        if(!output.is_open())
+        {
+            LOG_WARN_S << "Cannot write motion cache " << file;
+            return;
+        }
+
+        output.write(cacheMagic, sizeof(cacheMagic));
+        writeValue<uint64_t>(output, key.size());
+        output.write(key.data(), key.size());
+        writeValue<uint64_t>(output, idToMotion.size());
+        for(const Motion& motion : idToMotion)
+        {
+            writeValue(output, motion.xDiff);
+            writeValue(output, motion.yDiff);
+            writeValue(output, motion.endTheta.getTheta());
+            writeValue(output, motion.startTheta.getTheta());
+            writeValue<int>(output, motion.type);
+            writeValue(output, motion.baseCost);
+            writeValue(output, motion.costMultiplier);
+            writeValue(output, motion.translationlDist);
+            writeValue(output, motion.angularDist);
+            writeSteps(output, motion.intermediateStepsTravMap);
+            writeSteps(output, motion.intermediateStepsObstMap);
+            writeValue<uint64_t>(output, motion.fullSplineSamples.size());
+            for(const CellWithPoses& sample : motion.fullSplineSamples)
+            {
+                writeValue(output, sample.cell.x());
+                writeValue(output, sample.cell.y());
+                writeValue<uint64_t>(output, sample.poses.size());
+                for(const base::Pose2D& pose : sample.poses)
+                    writePose(output, pose);
+            }
+        }
+        if(!output.good())
+        {
+            LOG_WARN_S << "Cannot write motion cache " << file;
+            output.close();
+            std::remove(tmpFile.c_str());
+            return;
+        }
+    }
+
+    if(std::rename(tmpFile.c_str(), file.c_str()) != 0)
+    {
+        LOG_WARN_S << "Cannot write motion cache " << file;
+        std::remove(tmpFile.c_str());
+        return;
+    }
+    LOG_INFO_S << "Wrote " << idToMotion.size() << " motions to " << file;
 }
 
 void PreComputedMotions::sampleOnResolution(double gridResolution,base::geometry::Spline2 spline, std::vector<PoseWithCell> &result, std::vector<CellWithPoses> &fullResult)
@@ -316,9 +612,38 @@ const Motion& PreComputedMotions::getMotion(std::size_t id) const
     return idToMotion.at(id);
 }
 
+void PreComputedMotions::computeFootprints(const traversability_generator3d::TraversabilityConfig& config)
+{
+    idToFootprint.clear();
+    idToFootprint.reserve(idToMotion.size());
+    for(const Motion& motion : idToMotion)
+        idToFootprint.push_back(SweptFootprint(motion.intermediateStepsObstMap, config));
+}
+
+const SweptFootprint& PreComputedMotions::getFootprint(std::size_t id) const
+{
+    if(id >= idToFootprint.size())
+        throw std::runtime_error("PreComputedMotions::getFootprint: Error, footprints have not been computed");
+    return idToFootprint[id];
+}
+
+int PreComputedMotions::getMaxCellDistance() const
+{
+    int maxDist = 0;
+    for(const Motion& motion : idToMotion)
+    {
+        maxDist = std::max(maxDist, std::max(std::abs(motion.xDiff), std::abs(motion.yDiff)));
+        for(const PoseWithCell& step : motion.intermediateStepsTravMap)
+            maxDist = std::max(maxDist, std::max(std::abs(step.cell.x()), std::abs(step.cell.y())));
+    }
+    return maxDist;
+}
+
 const SbplSplineMotionPrimitives& PreComputedMotions::getPrimitives() const
 {
-    return primitives;
+    if(!primitives)
+        primitives.reset(new SbplSplineMotionPrimitives(primitiveConfig));
+    return *primitives;
 }
 
 double PreComputedMotions::calculateCurvatureFromRadius(const double r)
@@ -2,8 +2,11 @@
 
 #include "DiscreteTheta.hpp"
 #include "Mobility.hpp"
+#include "SweptFootprint.hpp"
 #include <limits>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <base/Pose.hpp>
 #include <maps/grid/Index.hpp>
@@ -37,7 +40,7 @@ public:
         MOV_FORWARD,
         MOV_BACKWARD,
         MOV_POINTTURN,
-        MOV_LATERAL,
+        MOV_LATERAL, //last type, the motion cache rejects values beyond it
     };
 
     Motion(unsigned int numAngles = 0) : endTheta(0, numAngles),startTheta(0, numAngles), baseCost(0), id(std::numeric_limits<size_t>::max()) {};
@@ -89,8 +92,13 @@ class PreComputedMotions
     //indexed by discrete start theta
     std::vector<std::vector<Motion> > thetaToMotion;
     std::vector<Motion> idToMotion;
-    sbpl_spline_primitives::SbplSplineMotionPrimitives primitives;
+    /** Indexed by motion id. Footprints of Motion::intermediateStepsObstMap */
+    std::vector<SweptFootprint> idToFootprint;
+    sbpl_spline_primitives::SplinePrimitivesConfig primitiveConfig;
+    /** Generated on first use, not needed if the motions are loaded from the cache */
+    mutable std::unique_ptr<sbpl_spline_primitives::SbplSplineMotionPrimitives> primitives;
     Mobility mobilityConfig;
+    std::string cacheDirectory;
 public:
     /**Initialize using spline based primitives.
      * @param mobilityConfig Will be used to configure and filter the splines.
@@ -103,7 +111,14 @@ public:
                               const Mobility& mobilityConfig,
                               double obstGridResolution, double travGridResolution);
     
+    /** Computes the motions for the given resolutions.
+     *  If a cache directory is set, the motions are loaded from it if they have been computed for the
+     *  same configuration before. Otherwise they are computed and written to the cache. */
     void computeMotions(double obstGridResolution, double travGridResolution);
+
+    /** Directory of the motion cache. An empty string disables the cache (default).
+     *  Needs to be set before computeMotions(). */
+    void setCacheDirectory(const std::string& directory);
     
     void setMotionForTheta(const Motion &motion, const DiscreteTheta &theta);
     
@@ -112,6 +127,16 @@ public:
     const std::vector<Motion> &getMotionForStartTheta(const DiscreteTheta &theta) const;
     
     const Motion &getMotion(std::size_t id) const; 
+
+    /** Computes the swept footprint of every motion on the obstacle map.
+     *  Needs to be called after the motions have been computed and whenever the robot size changes. */
+    void computeFootprints(const traversability_generator3d::TraversabilityConfig& config);
+
+    /** @return the cells that the robot and the cost corridor touch while following the motion @p id */
+    const SweptFootprint &getFootprint(std::size_t id) const;
+    
+    /**@return the largest distance (in trav map cells, per axis) any motion moves away from its start cell */
+    int getMaxCellDistance() const;
     
     const sbpl_spline_primitives::SbplSplineMotionPrimitives& getPrimitives() const;
     
@@ -126,6 +151,15 @@ private:
     
     void computeSplinePrimCost(const sbpl_spline_primitives::SplinePrimitive& prim,
                                const Mobility& mobilityConfig, Motion& outMotion) const;
+
+    /** @return a binary string that identifies everything the motions depend on */
+    std::string getCacheKey(double obstGridResolution, double travGridResolution) const;
+
+    /** Loads the motions from @p file.
+     *  @return false if the file does not exist, is damaged or has been written for a different @p key */
+    bool readCache(const std::string& file, const std::string& key);
+
+    void writeCache(const std::string& file, const std::string& key) const;
     
 };
 
@@ -0,0 +1,90 @@
+#include "StartPositionHistory.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace ugv_nav4d
+{
+
+StartPositionHistory::StartPositionHistory(double cellSize, size_t capacity) :
+    cellSize(0), capacity(capacity)
+{
+    setCellSize(cellSize);
+}
+
+size_t StartPositionHistory::CellHash::operator()(const Eigen::Vector3i& cell) const
+{
+    size_t hash = std::hash<int>()(cell.x());
+    hash = hash * 31 + std::hash<int>()(cell.y());
+    hash = hash * 31 + std::hash<int>()(cell.z());
+    return hash;
+}
+
+Eigen::Vector3i StartPositionHistory::toCell(const Eigen::Vector3d& pos) const
+{
+    return Eigen::Vector3i(std::floor(pos.x() / cellSize), std::floor(pos.y() / cellSize), std::floor(pos.z() / cellSize));
+}
+
+bool StartPositionHistory::add(const Eigen::Vector3d& pos)
+{
+    const Eigen::Vector3i cell = toCell(pos);
+    auto it = cellToEntry.find(cell);
+    if(it != cellToEntry.end())
+    {
+        //keep the latest position of the cell, it is the one that is known to be valid
+        it->second->pos = pos;
+        entries.splice(entries.begin(), entries, it->second);
+        return false;
+    }
+
+    entries.push_front(Entry{cell, pos});
+    cellToEntry.emplace(cell, entries.begin());
+
+    dropLeastRecentlyUsed();
+    return true;
+}
+
+void StartPositionHistory::dropLeastRecentlyUsed()
+{
+    while(capacity > 0 && entries.size() > capacity)
+    {
+        cellToEntry.erase(entries.back().cell);
+        entries.pop_back();
+    }
+}
+
+std::vector<Eigen::Vector3d> StartPositionHistory::getPositions() const
+{
+    std::vector<Eigen::Vector3d> positions;
+    positions.reserve(entries.size());
+    for(const Entry& entry : entries)
+        positions.push_back(entry.pos);
+    return positions;
+}
+
+size_t StartPositionHistory::size() const
+{
+    return entries.size();
+}
+
+void StartPositionHistory::clear()
+{
+    entries.clear();
+    cellToEntry.clear();
+}
+
+void StartPositionHistory::setCapacity(size_t capacity)
+{
+    this->capacity = capacity;
+    dropLeastRecentlyUsed();
+}
+
+void StartPositionHistory::setCellSize(double cellSize)
+{
+    if(cellSize <= 0)
+        throw std::runtime_error("StartPositionHistory: cellSize needs to be positive");
+    //the cells of the old size cannot be mapped to the new ones
+    clear();
+    this->cellSize = cellSize;
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+
+namespace ugv_nav4d
+{
+
+/** Remembers the most recent start positions of the planner.
+ *
+ *  Positions are deduplicated on a grid: only the latest position inside a
+ *  cell is kept. If more than @p capacity cells are occupied, the least recently
+ *  used cell is dropped. Thus the number of seeds for the map expansion stays
+ *  bounded, no matter how long the robot operates. */
+class StartPositionHistory
+{
+public:
+    /** @param cellSize edge length of the cubic deduplication cells (in meter)
+     *  @param capacity maximum number of positions, 0 means unbounded */
+    StartPositionHistory(double cellSize, size_t capacity);
+
+    /** Adds @p pos and marks its cell as most recently used.
+     *  @return true if a new cell has been occupied, false if the cell was already known */
+    bool add(const Eigen::Vector3d& pos);
+
+    /** @return all remembered positions, most recently used first */
+    std::vector<Eigen::Vector3d> getPositions() const;
+
+    size_t size() const;
+
+    void clear();
+
+    /** Changes the maximum number of positions. The least recently used positions are dropped
+     *  if there are more than @p capacity. 0 means unbounded */
+    void setCapacity(size_t capacity);
+
+    /** Changes the size of the deduplication cells. All positions are dropped */
+    void setCellSize(double cellSize);
+
+private:
+    struct CellHash
+    {
+        size_t operator()(const Eigen::Vector3i& cell) const;
+    };
+
+    struct Entry
+    {
+        Eigen::Vector3i cell;
+        Eigen::Vector3d pos;
+    };
+
+    Eigen::Vector3i toCell(const Eigen::Vector3d& pos) const;
+
+    /** Drops entries until there are at most capacity */
+    void dropLeastRecentlyUsed();
+
+    double cellSize;
+    size_t capacity;
+    /** most recently used entry first */
+    std::list<Entry> entries;
+    std::unordered_map<Eigen::Vector3i, std::list<Entry>::iterator, CellHash> cellToEntry;
+};
+
+}
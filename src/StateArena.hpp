@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ugv_nav4d
+{
+
+/** Chunked arena for the planner states.
+ *
+ *  Objects are constructed in chunks of @p ChunkSize objects instead of being allocated
+ *  one by one. clear() destroys all objects but keeps the chunks, thus they are reused by
+ *  the next plan. For trivially destructible types clear() is O(1), no object is visited.
+ *
+ *  create() is lock-free and may be called concurrently. Like the ConcurrentStateTable
+ *  the arena does not grow during concurrent use, reserve() has to be called beforehand. */
+template <class T, size_t ChunkSize = 4096>
+class StateArena
+{
+public:
+    StateArena() : numObjects(0)
+    {
+    }
+
+    StateArena(const StateArena&) = delete;
+    StateArena& operator=(const StateArena&) = delete;
+
+    ~StateArena()
+    {
+        clear();
+    }
+
+    /** Makes room for at least @p numObjects objects in total.
+     *  Not thread-safe, must not run concurrently with any other method. */
+    void reserve(size_t numObjects)
+    {
+        while(capacity() < numObjects)
+            chunks.emplace_back(new Storage[ChunkSize]);
+    }
+
+    /** Constructs a new object from @p args.
+     *  The number of objects must not exceed the reserved capacity. */
+    template <class... Args>
+    T* create(Args&&... args)
+    {
+        const size_t i = numObjects.fetch_add(1, std::memory_order_relaxed);
+        assert(i < capacity() && "StateArena: reserve() was not called");
+        return new (at(i)) T(std::forward<Args>(args)...);
+    }
+
+    /** Destroys all objects. The memory is kept for reuse. Not thread-safe. */
+    void clear()
+    {
+        destroyAll(std::is_trivially_destructible<T>());
+        numObjects.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const
+    {
+        return numObjects.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return chunks.size() * ChunkSize;
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    void* at(size_t i)
+    {
+        return &chunks[i / ChunkSize][i % ChunkSize];
+    }
+
+    void destroyAll(std::true_type /*trivially destructible*/)
+    {
+    }
+
+    void destroyAll(std::false_type /*trivially destructible*/)
+    {
+        const size_t n = size();
+        for(size_t i = 0; i < n; ++i)
+            static_cast<T*>(at(i))->~T();
+    }
+
+    std::vector<std::unique_ptr<Storage[]>> chunks;
+    std::atomic<size_t> numObjects;
+};
+
+/** Grows @p values to at least @p minSize elements, the size is at least doubled.
+ *  std::atomic is not movable, thus the vector cannot be resized. The values are copied into
+ *  a new vector instead and the new elements are set to @p initial. Not thread-safe. */
+template <class T>
+void growAtomicVector(std::vector<std::atomic<T>>& values, size_t minSize, T initial)
+{
+    if(values.size() >= minSize)
+        return;
+
+    std::vector<std::atomic<T>> grown(std::max(minSize, 2 * values.size()));
+    for(size_t i = 0; i < values.size(); ++i)
+        grown[i].store(values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    for(size_t i = values.size(); i < grown.size(); ++i)
+        grown[i].store(initial, std::memory_order_relaxed);
+    values.swap(grown);
+}
+
+}
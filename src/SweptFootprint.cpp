@@ -0,0 +1,150 @@
+#include "SweptFootprint.hpp"
+#include "PreComputedMotions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <utility>
+#include <Eigen/Geometry>
+
+namespace ugv_nav4d
+{
+
+constexpr size_t SweptFootprint::maxParents;
+
+SweptFootprint::SweptFootprint()
+{
+}
+
+SweptFootprint::SweptFootprint(const std::vector<PoseWithCell>& steps,
+                               const traversability_generator3d::TraversabilityConfig& config)
+{
+    if(steps.empty())
+        return;
+
+    const double res = config.gridResolution;
+    const double inf = std::numeric_limits<double>::infinity();
+
+    const Eigen::Vector2d halfRobotDimension(config.robotSizeX / 2.0, config.robotSizeY / 2.0);
+    const Eigen::Vector2d halfOuterBoxDimension(halfRobotDimension + Eigen::Vector2d::Constant(config.costFunctionDist));
+    const Eigen::AlignedBox<double, 2> robotBoundingBox(- halfRobotDimension, halfRobotDimension);
+    const Eigen::AlignedBox<double, 2> costFunctionBoundingBox(- halfOuterBoxDimension, halfOuterBoxDimension);
+
+    const std::array<Eigen::Vector2d, 4> edgePositions = {
+        Eigen::Vector2d(- res / 2.0, - res / 2.0),
+        Eigen::Vector2d(- res / 2.0, res / 2.0),
+        Eigen::Vector2d(res / 2.0, res / 2.0),
+        Eigen::Vector2d(res / 2.0, - res / 2.0)
+    };
+
+    //every cell that has a corner inside the corridor is within this radius of the pose
+    const double searchRadius = halfOuterBoxDimension.norm() + res;
+
+    typedef std::pair<int, int> Key;
+    struct Distances
+    {
+        double robot;
+        double boundary;
+    };
+    std::map<Key, Distances> touched;
+
+    for(const PoseWithCell& step : steps)
+    {
+        const Eigen::Vector2d& pos(step.pose.position);
+        const Eigen::Rotation2D<double> yawInverse(Eigen::Rotation2D<double>(step.pose.orientation).inverse());
+
+        const int minX = std::ceil((pos.x() - searchRadius) / res);
+        const int maxX = std::floor((pos.x() + searchRadius) / res);
+        const int minY = std::ceil((pos.y() - searchRadius) / res);
+        const int maxY = std::floor((pos.y() + searchRadius) / res);
+
+        for(int x = minX; x <= maxX; ++x)
+        {
+            for(int y = minY; y <= maxY; ++y)
+            {
+                //the cell centers are relative to the center of the start cell
+                const Eigen::Vector2d cellCenter(x * res, y * res);
+                const double distToPathCell = (Eigen::Vector2d(x - step.cell.x(), y - step.cell.y()) * res).norm();
+
+                bool isInsideOuterBox = false;
+                double robotDist = inf;
+                double boundaryDist = inf;
+                //a cell is touched if any of its four corners is inside the box
+                for(const Eigen::Vector2d &ep : edgePositions)
+                {
+                    const Eigen::Vector2d tp = yawInverse * (cellCenter + ep - pos);
+                    if(!costFunctionBoundingBox.contains(tp))
+                        continue;
+
+                    isInsideOuterBox = true;
+                    if(robotBoundingBox.contains(tp))
+                        robotDist = distToPathCell;
+                    else
+                        boundaryDist = std::min(boundaryDist, robotBoundingBox.exteriorDistance(tp));
+                }
+
+                if(!isInsideOuterBox)
+                    continue;
+
+                auto it = touched.insert(std::make_pair(Key(x, y), Distances{inf, inf})).first;
+                it->second.robot = std::min(it->second.robot, robotDist);
+                it->second.boundary = std::min(it->second.boundary, boundaryDist);
+            }
+        }
+    }
+
+    //the start cell is the root of the walk, even if the robot does not touch it
+    touched.insert(std::make_pair(Key(0, 0), Distances{inf, inf}));
+
+    //sort breadth first, cells that cannot be reached via touched cells are dropped.
+    //A flood fill on the map would not reach them either.
+    std::map<Key, uint32_t> order;
+    std::deque<Key> queue;
+    order[Key(0, 0)] = 0;
+    queue.push_back(Key(0, 0));
+    while(!queue.empty())
+    {
+        const Key key = queue.front();
+        queue.pop_front();
+
+        Cell cell;
+        cell.offset = maps::grid::Index(key.first, key.second);
+        cell.robotDistance = touched[key].robot;
+        cell.boundaryDistance = touched[key].boundary;
+        cell.numParents = 0;
+
+        std::vector<uint32_t> earlierNeighbors;
+        for(int dx = -1; dx <= 1; ++dx)
+        {
+            for(int dy = -1; dy <= 1; ++dy)
+            {
+                if(dx == 0 && dy == 0)
+                    continue;
+                const Key neighbor(key.first + dx, key.second + dy);
+                if(touched.find(neighbor) == touched.end())
+                    continue;
+
+                auto it = order.find(neighbor);
+                if(it == order.end())
+                {
+                    const uint32_t index = order.size();
+                    order[neighbor] = index;
+                    queue.push_back(neighbor);
+                }
+                else if(it->second < cells.size())
+                {
+                    earlierNeighbors.push_back(it->second);
+                }
+            }
+        }
+
+        //the neighbor that discovered this cell comes first
+        std::sort(earlierNeighbors.begin(), earlierNeighbors.end());
+        for(size_t i = 0; i < earlierNeighbors.size() && i < maxParents; ++i)
+            cell.parents[cell.numParents++] = earlierNeighbors[i];
+
+        cells.push_back(cell);
+    }
+}
+
+}
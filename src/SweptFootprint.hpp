@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <maps/grid/Index.hpp>
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+
+namespace ugv_nav4d
+{
+
+struct PoseWithCell;
+
+/** The cells that are touched by the robot box and by the cost function corridor
+ *  around it while the robot follows a sequence of poses.
+ *
+ *  All geometry is computed once: the cells are given as offsets to the start cell
+ *  and carry their distances to the robot. Checking a path on the obstacle map is
+ *  then a walk over the cell list (see PathStatistic), no flood fill and no
+ *  transformations are needed.
+ *
+ *  The cells are sorted in breadth first order starting at the start cell. Every cell
+ *  (except the start cell) has at least one neighbor earlier in the list. On a multi
+ *  level map the node of a cell is found via the connections of those neighbors. */
+class SweptFootprint
+{
+public:
+    static constexpr size_t maxParents = 4;
+
+    struct Cell
+    {
+        /** Offset to the start cell */
+        maps::grid::Index offset;
+        /** Smallest distance (in meter) between this cell and the path cell of a pose
+         *  whose robot box overlaps it. Infinity if no robot box overlaps it */
+        double robotDistance;
+        /** Smallest distance (in meter) between the robot box and a corner of this cell
+         *  that lies inside the corridor but outside of the robot. Infinity if there is none */
+        double boundaryDistance;
+        /** Indices of the neighbor cells that come earlier in the list */
+        std::array<uint32_t, maxParents> parents;
+        uint8_t numParents;
+
+        bool isInsideRobot() const
+        {
+            return robotDistance != std::numeric_limits<double>::infinity();
+        }
+
+        bool isInsideBoundary() const
+        {
+            return !isInsideRobot() && boundaryDistance != std::numeric_limits<double>::infinity();
+        }
+    };
+
+    SweptFootprint();
+
+    /** @param steps Poses of the robot relative to the center of the start cell and the
+     *               cells that contain them (relative to the start cell), e.g.
+     *               Motion::intermediateStepsObstMap. If empty, the footprint is empty as well.
+     *  @param config The robot size, the width of the corridor (costFunctionDist) and
+     *                the grid resolution are taken from here. */
+    SweptFootprint(const std::vector<PoseWithCell>& steps,
+                   const traversability_generator3d::TraversabilityConfig& config);
+
+    /** @return all cells in breadth first order, the start cell first */
+    const std::vector<Cell>& getCells() const
+    {
+        return cells;
+    }
+
+    bool empty() const
+    {
+        return cells.empty();
+    }
+
+private:
+    std::vector<Cell> cells;
+};
+
+}
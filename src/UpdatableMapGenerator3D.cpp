@@ -0,0 +1,151 @@
+#include "UpdatableMapGenerator3D.hpp"
+#include <algorithm>
+#include <deque>
+
+using namespace maps::grid;
+
+namespace ugv_nav4d
+{
+
+namespace
+{
+
+/** TraversabilityNodeBase has no interface to remove connections. A member pointer taken
+ *  through a derived class gives access to the protected connections of any node. */
+struct ConnectionAccess : public TraversabilityNodeBase
+{
+    static std::vector<TraversabilityNodeBase *> &get(TraversabilityNodeBase *node)
+    {
+        return node->*(&ConnectionAccess::connections);
+    }
+};
+
+/** Keeps the first of all connections to the same node, the order is not changed */
+void removeDuplicateConnections(TraversabilityNodeBase *node)
+{
+    std::vector<TraversabilityNodeBase *> &connections(ConnectionAccess::get(node));
+    auto end = connections.begin();
+    for(auto it = connections.begin(); it != connections.end(); ++it)
+    {
+        if(std::find(connections.begin(), end, *it) == end)
+            *end++ = *it;
+    }
+    connections.erase(end, connections.end());
+}
+
+}
+
+UpdatableMapGenerator3D::UpdatableMapGenerator3D(const traversability_generator3d::TraversabilityConfig& config): TraversabilityGenerator3d(config)
+{
+
+}
+
+UpdatableMapGenerator3D::~UpdatableMapGenerator3D()
+{
+
+}
+
+void UpdatableMapGenerator3D::setMLSGrid(const std::shared_ptr<MLGrid>& mlsGrid)
+{
+    //all nodes are deleted
+    resetNodes.clear();
+    TraversabilityGenerator3d::setMLSGrid(mlsGrid);
+}
+
+size_t UpdatableMapGenerator3D::updateRegion(std::shared_ptr<MLGrid> mlsGrid, const Index& min, const Index& max)
+{
+    //do not use setMLSGrid(), it clears the whole map
+    this->mlsGrid = mlsGrid;
+
+    const Index first(std::max(min.x(), 0), std::max(min.y(), 0));
+    const Index last(std::min<int>(max.x(), trMap.getNumCells().x() - 1), std::min<int>(max.y(), trMap.getNumCells().y() - 1));
+    auto inRegion = [&](const TraversabilityNodeBase *node)
+    {
+        const Index &idx(node->getIndex());
+        return idx.x() >= first.x() && idx.x() <= last.x() && idx.y() >= first.y() && idx.y() <= last.y();
+    };
+
+    //the nodes of the region are removed. They are generated again from the new grid when their
+    //neighbors are expanded, thus the heights and connections of the region follow the new grid
+    std::vector<traversability_generator3d::TravGenNode *> removed;
+    std::vector<traversability_generator3d::TravGenNode *> border;
+    for(int y = first.y(); y <= last.y(); ++y)
+    {
+        for(int x = first.x(); x <= last.x(); ++x)
+        {
+            LevelList<traversability_generator3d::TravGenNode *> &nodes(trMap.at(Index(x, y)));
+            for(traversability_generator3d::TravGenNode *node : nodes)
+            {
+                removed.push_back(node);
+                for(TraversabilityNodeBase *connected : node->getConnections())
+                {
+                    if(!inRegion(connected))
+                        border.push_back(static_cast<traversability_generator3d::TravGenNode *>(connected));
+                }
+            }
+            nodes.clear();
+        }
+    }
+
+    //the neighbors of the region lose their connections into it. They are expanded again by
+    //expandResetNodes(), which generates the new nodes of the region and connects them.
+    //expandNode() skips nodes that are already classified, thus the type needs to be reset as well
+    std::sort(border.begin(), border.end());
+    border.erase(std::unique(border.begin(), border.end()), border.end());
+    for(traversability_generator3d::TravGenNode *node : border)
+    {
+        std::vector<TraversabilityNodeBase *> &connections(ConnectionAccess::get(node));
+        connections.erase(std::remove_if(connections.begin(), connections.end(), inRegion), connections.end());
+        node->setType(TraversabilityNodeBase::UNSET);
+        node->setNotExpanded();
+    }
+
+    //earlier updates may have queued nodes of this region
+    resetNodes.erase(std::remove_if(resetNodes.begin(), resetNodes.end(), inRegion), resetNodes.end());
+    obstacleNodesGrowList.erase(std::remove_if(obstacleNodesGrowList.begin(), obstacleNodesGrowList.end(), inRegion),
+                                obstacleNodesGrowList.end());
+    resetNodes.insert(resetNodes.end(), border.begin(), border.end());
+
+    for(traversability_generator3d::TravGenNode *node : removed)
+        delete node;
+    return removed.size();
+}
+
+size_t UpdatableMapGenerator3D::expandResetNodes()
+{
+    std::deque<traversability_generator3d::TravGenNode *> candidates(resetNodes.begin(), resetNodes.end());
+    std::vector<traversability_generator3d::TravGenNode *> reconnected;
+    reconnected.swap(resetNodes);
+
+    //same wave as expandAll(), starting at the reset nodes
+    size_t numExpanded = 0;
+    while(!candidates.empty())
+    {
+        traversability_generator3d::TravGenNode *node = candidates.front();
+        candidates.pop_front();
+        if(node->isExpanded())
+            continue;
+
+        ++numExpanded;
+        if(!expandNode(node))
+            continue;
+
+        for(TraversabilityNodeBase *connected : node->getConnections())
+        {
+            if(!connected->isExpanded())
+                candidates.push_back(static_cast<traversability_generator3d::TravGenNode *>(connected));
+        }
+    }
+
+    //the reset nodes kept their connections to the outside of the region,
+    //expanding them again connected them to their neighbors a second time
+    for(traversability_generator3d::TravGenNode *node : reconnected)
+    {
+        removeDuplicateConnections(node);
+        for(TraversabilityNodeBase *connected : node->getConnections())
+            removeDuplicateConnections(connected);
+    }
+    return numExpanded;
+}
+
+}
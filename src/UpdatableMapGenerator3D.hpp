@@ -0,0 +1,38 @@
+#pragma once
+#include <traversability_generator3d/TraversabilityGenerator3d.hpp>
+#include <utility>
+#include <vector>
+
+namespace ugv_nav4d
+{
+    /** A TraversabilityGenerator3d that can exchange its mls grid without
+     *  throwing away the already generated map.*/
+    class UpdatableMapGenerator3D : public traversability_generator3d::TraversabilityGenerator3d
+    {
+    public:
+        UpdatableMapGenerator3D(const traversability_generator3d::TraversabilityConfig &config);
+        virtual ~UpdatableMapGenerator3D();
+
+        /** Replaces the mls grid and clears the whole map, see TraversabilityGenerator3d::setMLSGrid() */
+        void setMLSGrid(const std::shared_ptr<MLGrid> &mlsGrid);
+
+        /** Replaces the mls grid and removes all nodes inside the rectangle [@p min, @p max]
+         *  (in map cells, inclusive) together with their connections. The neighbors of the removed
+         *  nodes are reset, expandResetNodes() generates the nodes of the region again from the new grid.
+         *  All other nodes are kept as they are.
+         *  @note The removed nodes are deleted, pointers to them must not be used anymore. Their ids are not reused.
+         *  @note The new grid needs to have the same geometry as the old one.
+         *  @return number of removed nodes */
+        virtual size_t updateRegion(std::shared_ptr<MLGrid> mlsGrid, const maps::grid::Index &min, const maps::grid::Index &max);
+
+        /** Expands the nodes that have been reset by updateRegion() and the new nodes that
+         *  are reachable from them. expandAll() stops at nodes that are already expanded, thus
+         *  it does not reach reset nodes that are surrounded by expanded ones.
+         *  @return number of expanded nodes */
+        size_t expandResetNodes();
+
+    private:
+        /** The neighbors of the regions removed by updateRegion() since the last expandResetNodes() */
+        std::vector<traversability_generator3d::TravGenNode *> resetNodes;
+    };
+}
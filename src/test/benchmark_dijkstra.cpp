@@ -0,0 +1,109 @@
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include "ugv_nav4d/Dijkstra.hpp"
+#include <traversability_generator3d/TraversabilityGenerator3d.hpp>
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <maps/grid/MLSMap.hpp>
+
+#include <pcl/io/ply_io.h>
+#include <pcl/common/common.h>
+#include <pcl/common/transforms.h>
+
+using namespace ugv_nav4d;
+
+typedef traversability_generator3d::TraversabilityGenerator3d::MLGrid MLSBase;
+
+/** Compares the runtime of the hash map based Dijkstra and the bucket queue based Dijkstra
+ *  on a traversability map that is generated from a ply file.
+ *  Usage: benchmark_dijkstra <map.ply> <startX> <startY> <startZ> [iterations] */
+int main(int argc, char** argv)
+{
+    if(argc < 5)
+    {
+        std::cout << "Usage: " << argv[0] << " <map.ply> <startX> <startY> <startZ> [iterations]" << std::endl;
+        return 1;
+    }
+
+    const std::string path(argv[1]);
+    const Eigen::Vector3d startPos(atof(argv[2]), atof(argv[3]), atof(argv[4]));
+    const int iterations = argc > 5 ? atoi(argv[5]) : 10;
+
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+    pcl::PLYReader plyReader;
+    if(plyReader.read(path, *cloud) < 0)
+    {
+        std::cout << "Unable to load " << path << std::endl;
+        return 1;
+    }
+    pcl::PointXYZ mi, ma;
+    pcl::getMinMax3D(*cloud, mi, ma);
+
+    Eigen::Affine3f pclTf = Eigen::Affine3f::Identity();
+    pclTf.translation() << -mi.x, -mi.y, -mi.z;
+    pcl::transformPointCloud(*cloud, *cloud, pclTf);
+
+    const double mls_res = 0.3;
+    const maps::grid::Vector2ui numCells((ma.x - mi.x) / mls_res + 1, (ma.y - mi.y) / mls_res + 1);
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped mlsMap(numCells, maps::grid::Vector2d(mls_res, mls_res), cfg);
+    mlsMap.mergePointCloud(*cloud, base::Transform3d::Identity());
+
+    traversability_generator3d::TraversabilityConfig travConf;
+    travConf.maxStepHeight = 0.25;
+    travConf.maxSlope = 0.45;
+    travConf.robotHeight = 1.2;
+    travConf.robotSizeX = 1.35;
+    travConf.robotSizeY = 0.85;
+    travConf.gridResolution = 0.3;
+    travConf.minTraversablePercentage = 0.4;
+    travConf.initialPatchVariance = 0.0001;
+    travConf.enableInclineLimitting = false;
+
+    traversability_generator3d::TraversabilityGenerator3d travGen(travConf);
+    travGen.setMLSGrid(std::make_shared<MLSBase>(mlsMap));
+    travGen.expandAll(std::vector<Eigen::Vector3d>{startPos});
+
+    const traversability_generator3d::TravGenNode* source = travGen.generateStartNode(startPos);
+    if(!source)
+    {
+        std::cout << "Unable to generate start node" << std::endl;
+        return 1;
+    }
+    std::cout << "Map has " << travGen.getNumNodes() << " nodes" << std::endl;
+
+    std::unordered_map<const maps::grid::TraversabilityNodeBase*, double> mapDistances;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+        Dijkstra::computeCost(source, mapDistances, travConf);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<double> flatDistances;
+    const double maxDist = 99999999;
+    for(int i = 0; i < iterations; ++i)
+        Dijkstra::computeCost(source, flatDistances, travGen.getNumNodes(), maxDist, travConf);
+    auto t2 = std::chrono::steady_clock::now();
+
+    //both versions have to produce the same distances
+    size_t mismatches = 0;
+    for(const auto& pair : mapDistances)
+    {
+        const auto* node = static_cast<const traversability_generator3d::TravGenNode*>(pair.first);
+        if(std::abs(flatDistances[node->getUserData().id] - pair.second) > 1e-6)
+            ++mismatches;
+    }
+
+    const double mapMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+    const double flatMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+    std::cout << "hash map + std::set: " << mapMs << " ms" << std::endl;
+    std::cout << "flat array + bucket queue: " << flatMs << " ms" << std::endl;
+    std::cout << "speedup: " << mapMs / flatMs << std::endl;
+    std::cout << "reached nodes: " << mapDistances.size() << ", mismatches: " << mismatches << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
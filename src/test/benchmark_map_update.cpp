@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "ugv_nav4d/Planner.hpp"
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <maps/grid/MLSMap.hpp>
+
+#include <pcl/io/ply_io.h>
+#include <pcl/common/common.h>
+#include <pcl/common/transforms.h>
+
+using namespace ugv_nav4d;
+
+typedef EnvironmentXYZTheta::MLGrid MLSBase;
+
+/** @return a value from /proc/self/status in kB, e.g. VmHWM (peak resident memory) */
+static long readStatus(const std::string& key)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+    {
+        if(line.compare(0, key.size() + 1, key + ":") == 0)
+            return std::stol(line.substr(key.size() + 1));
+    }
+    return -1;
+}
+
+/** Resets the peak resident memory (VmHWM) to the current resident memory */
+static void resetPeakMemory()
+{
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/** Measures the latency and the peak memory increase of one map update.
+ *  @p prepare runs before each update and is not measured */
+template <class Prepare, class Update>
+static void measure(const std::string& name, int iterations, Prepare prepare, Update update)
+{
+    double totalMs = 0;
+    long peakIncrease = 0;
+    for(int i = 0; i < iterations; ++i)
+    {
+        prepare();
+        resetPeakMemory();
+        const long before = readStatus("VmRSS");
+        const auto t0 = std::chrono::steady_clock::now();
+        update();
+        const auto t1 = std::chrono::steady_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        peakIncrease = std::max(peakIncrease, readStatus("VmHWM") - before);
+    }
+    std::cout << name << ": " << totalMs / iterations << " ms, peak memory increase " << peakIncrease / 1024.0 << " MB" << std::endl;
+}
+
+/** Compares the latency and the peak memory of handing a map to the planner
+ *  by copy, by move and by shared pointer.
+ *  Usage: benchmark_map_update <map.ply> [iterations] */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <map.ply> [iterations]" << std::endl;
+        return 1;
+    }
+
+    const std::string path(argv[1]);
+    const int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+    pcl::PLYReader plyReader;
+    if(plyReader.read(path, *cloud) < 0)
+    {
+        std::cout << "Unable to load " << path << std::endl;
+        return 1;
+    }
+    pcl::PointXYZ mi, ma;
+    pcl::getMinMax3D(*cloud, mi, ma);
+
+    Eigen::Affine3f pclTf = Eigen::Affine3f::Identity();
+    pclTf.translation() << -mi.x, -mi.y, -mi.z;
+    pcl::transformPointCloud(*cloud, *cloud, pclTf);
+
+    const double mls_res = 0.3;
+    const maps::grid::Vector2ui numCells((ma.x - mi.x) / mls_res + 1, (ma.y - mi.y) / mls_res + 1);
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped mlsMap(numCells, maps::grid::Vector2d(mls_res, mls_res), cfg);
+    mlsMap.mergePointCloud(*cloud, base::Transform3d::Identity());
+
+    sbpl_spline_primitives::SplinePrimitivesConfig splinePrimitiveConfig;
+    splinePrimitiveConfig.gridSize = 0.3;
+    splinePrimitiveConfig.numAngles = 42;
+    splinePrimitiveConfig.numEndAngles = 21;
+    splinePrimitiveConfig.destinationCircleRadius = 10;
+    splinePrimitiveConfig.cellSkipFactor = 3;
+    splinePrimitiveConfig.splineOrder = 4.0;
+
+    Mobility mobility;
+    mobility.translationSpeed = 0.5;
+    mobility.rotationSpeed = 0.5;
+    mobility.minTurningRadius = 1;
+    mobility.spline_sampling_resolution = 0.05;
+
+    traversability_generator3d::TraversabilityConfig travConf;
+    travConf.maxStepHeight = 0.25;
+    travConf.maxSlope = 0.45;
+    travConf.robotHeight = 1.2;
+    travConf.robotSizeX = 1.35;
+    travConf.robotSizeY = 0.85;
+    travConf.gridResolution = 0.3;
+    travConf.minTraversablePercentage = 0.4;
+    travConf.initialPatchVariance = 0.0001;
+    travConf.enableInclineLimitting = false;
+
+    PlannerConfig plannerConfig;
+    Planner planner(splinePrimitiveConfig, travConf, mobility, plannerConfig);
+    //the first update computes the motion primitives, do not measure it
+    planner.updateMap(mlsMap);
+
+    std::cout << "Map has " << numCells.x() << " x " << numCells.y() << " cells, resident memory "
+              << readStatus("VmRSS") / 1024.0 << " MB" << std::endl;
+
+    measure("copy (const MLSBase&)", iterations, [](){}, [&]()
+    {
+        planner.updateMap(mlsMap);
+    });
+
+    //the copies are made outside of the measurement, they simulate a mapping thread that
+    //hands over a new map
+    MLSBase movedMap;
+    measure("move (MLSBase&&)", iterations, [&]()
+    {
+        movedMap = mlsMap;
+    }, [&]()
+    {
+        planner.updateMap(std::move(movedMap));
+    });
+
+    std::shared_ptr<const MLSBase> sharedMap;
+    measure("shared (std::shared_ptr<const MLSBase>)", iterations, [&]()
+    {
+        sharedMap = std::make_shared<const MLSBase>(mlsMap);
+    }, [&]()
+    {
+        planner.updateMap(sharedMap);
+        //the planner is the only owner now, like after a hand over from a mapping thread
+        sharedMap.reset();
+    });
+
+    return 0;
+}
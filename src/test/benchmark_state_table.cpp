@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ugv_nav4d/ConcurrentStateTable.hpp"
+#include "ugv_nav4d/DiscreteTheta.hpp"
+#include "ugv_nav4d/EnvironmentXYZTheta.hpp"
+#include "ugv_nav4d/ParallelSearch.hpp"
+#include <sbpl/utils/mdpconfig.h>
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <maps/grid/MLSMap.hpp>
+
+#include <pcl/io/ply_io.h>
+#include <pcl/common/common.h>
+#include <pcl/common/transforms.h>
+
+using namespace ugv_nav4d;
+
+typedef EnvironmentXYZTheta::MLGrid MLSBase;
+/** (travNode id, theta) */
+typedef std::pair<size_t, int> StateKey;
+
+static double msSince(const std::chrono::steady_clock::time_point& t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+/** Inserts @p keys (in this order) into the per position std::map<DiscreteTheta, id> that was used
+ *  to look up states and into the theta slot blocks of the ConcurrentStateTable. Every key is looked
+ *  up a second time afterwards. Reports time, memory and the time to clear both for the next plan. */
+static bool compare(const std::string& name, const std::vector<StateKey>& keys, size_t numTravNodes, int numAngles)
+{
+    //the maps were members of the search nodes, which only existed for positions with states
+    std::map<size_t, std::map<DiscreteTheta, int>> thetaToNodes;
+    int nextId = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        for(const StateKey& key : keys)
+        {
+            std::map<DiscreteTheta, int>& thetaMap(thetaToNodes[key.first]);
+            const DiscreteTheta theta(key.second, numAngles);
+            if(thetaMap.find(theta) == thetaMap.end())
+                thetaMap.insert(std::make_pair(theta, nextId++));
+        }
+    }
+    const double mapMs = msSince(t0);
+
+    //libstdc++ red-black tree node: 32 byte header + key/value pair, the map object itself
+    const size_t mapEntryBytes = 32 + sizeof(std::pair<const DiscreteTheta, int>);
+    const size_t positionBytes = 32 + sizeof(std::pair<const size_t, std::map<DiscreteTheta, int>>);
+    const size_t mapBytes = nextId * mapEntryBytes + thetaToNodes.size() * positionBytes;
+
+    t0 = std::chrono::steady_clock::now();
+    thetaToNodes.clear();
+    const double mapClearMs = msSince(t0);
+
+    //like the environment, a block of slots is created for every position that has states.
+    //The blocks are found by a pointer per trav node (travNodeIdToXYZNode in the environment)
+    ConcurrentStateTable table(numAngles);
+    std::vector<std::atomic<int>*> travNodeToBlock(numTravNodes, nullptr);
+    table.reserve(std::min(keys.size(), numTravNodes));
+    t0 = std::chrono::steady_clock::now();
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        for(const StateKey& key : keys)
+        {
+            std::atomic<int>*& block(travNodeToBlock[key.first]);
+            if(!block)
+                block = table.createBlock();
+            table.findOrInsert(block, key.second, [](int) {});
+        }
+    }
+    const double tableMs = msSince(t0);
+    const size_t blockBytes = table.getNumBlocks() * numAngles * sizeof(std::atomic<int>) +
+                              travNodeToBlock.size() * sizeof(std::atomic<int>*);
+
+    t0 = std::chrono::steady_clock::now();
+    const size_t tableStates = table.size();
+    table.clear();
+    std::fill(travNodeToBlock.begin(), travNodeToBlock.end(), nullptr);
+    const double tableClearMs = msSince(t0);
+
+    std::cout << name << ": " << nextId << " states, " << 2 * keys.size() << " lookups" << std::endl;
+    std::cout << "  std::map per position: " << mapMs << " ms, " << mapBytes / 1024.0 / 1024.0 << " MiB, clear "
+              << mapClearMs << " ms" << std::endl;
+    std::cout << "  theta slot blocks:     " << tableMs << " ms, " << blockBytes / 1024.0 / 1024.0
+              << " MiB, clear " << tableClearMs << " ms" << std::endl;
+    return tableStates == static_cast<size_t>(nextId);
+}
+
+/** Compares the per position std::map<DiscreteTheta, id> that was used to look up
+ *  states with the theta slot blocks of the ConcurrentStateTable.
+ *  The states that a real search from start to goal creates are replayed in the order of
+ *  their creation. For comparison, every orientation on every connected node is inserted as well,
+ *  which is the upper bound of the states a search can create.
+ *  Usage: benchmark_state_table <map.ply> <startX> <startY> <startZ> <goalX> <goalY> <goalZ> [numAngles] */
+int main(int argc, char** argv)
+{
+    if(argc < 8)
+    {
+        std::cout << "Usage: " << argv[0] << " <map.ply> <startX> <startY> <startZ> <goalX> <goalY> <goalZ> [numAngles]" << std::endl;
+        return 1;
+    }
+
+    const std::string path(argv[1]);
+    const Eigen::Vector3d startPos(atof(argv[2]), atof(argv[3]), atof(argv[4]));
+    const Eigen::Vector3d goalPos(atof(argv[5]), atof(argv[6]), atof(argv[7]));
+    const int numAngles = argc > 8 ? atoi(argv[8]) : 16;
+
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+    pcl::PLYReader plyReader;
+    if(plyReader.read(path, *cloud) < 0)
+    {
+        std::cout << "Unable to load " << path << std::endl;
+        return 1;
+    }
+    pcl::PointXYZ mi, ma;
+    pcl::getMinMax3D(*cloud, mi, ma);
+
+    Eigen::Affine3f pclTf = Eigen::Affine3f::Identity();
+    pclTf.translation() << -mi.x, -mi.y, -mi.z;
+    pcl::transformPointCloud(*cloud, *cloud, pclTf);
+
+    const double mls_res = 0.3;
+    const maps::grid::Vector2ui numCells((ma.x - mi.x) / mls_res + 1, (ma.y - mi.y) / mls_res + 1);
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped mlsMap(numCells, maps::grid::Vector2d(mls_res, mls_res), cfg);
+    mlsMap.mergePointCloud(*cloud, base::Transform3d::Identity());
+
+    sbpl_spline_primitives::SplinePrimitivesConfig splinePrimitiveConfig;
+    splinePrimitiveConfig.gridSize = 0.3;
+    splinePrimitiveConfig.numAngles = numAngles;
+    splinePrimitiveConfig.numEndAngles = numAngles / 2;
+    splinePrimitiveConfig.destinationCircleRadius = 6;
+    splinePrimitiveConfig.cellSkipFactor = 0.1;
+    splinePrimitiveConfig.splineOrder = 4.0;
+
+    Mobility mobility;
+    mobility.translationSpeed = 0.5;
+    mobility.rotationSpeed = 0.5;
+    mobility.minTurningRadius = 1;
+    mobility.spline_sampling_resolution = 0.05;
+    mobility.maxMotionCurveLength = 100;
+
+    traversability_generator3d::TraversabilityConfig travConf;
+    travConf.maxStepHeight = 0.25;
+    travConf.maxSlope = 0.45;
+    travConf.robotHeight = 1.2;
+    travConf.robotSizeX = 1.35;
+    travConf.robotSizeY = 0.85;
+    travConf.gridResolution = 0.3;
+    travConf.minTraversablePercentage = 0.4;
+    travConf.initialPatchVariance = 0.0001;
+    travConf.enableInclineLimitting = false;
+
+    //record the states of a real search
+    EnvironmentXYZTheta env(std::make_shared<MLSBase>(mlsMap), travConf, splinePrimitiveConfig, mobility);
+    env.expandMap({startPos});
+    env.setStart(startPos, 0);
+    env.setGoal(goalPos, 0);
+    MDPConfig mdpCfg;
+    if(!env.InitializeMDPCfg(&mdpCfg))
+        return 1;
+    std::vector<int> solution;
+    ParallelSearch search(env, 1);
+    if(!search.search(mdpCfg.startstateid, mdpCfg.goalstateid, 3.0, 60.0, solution))
+    {
+        std::cout << "No solution found" << std::endl;
+        return 1;
+    }
+
+    //the ids are assigned in the order of creation
+    std::vector<StateKey> searchKeys;
+    for(int id = 0; id < env.SizeofCreatedEnv(); ++id)
+        searchKeys.push_back(env.getStateKey(id));
+
+    const traversability_generator3d::TraversabilityGenerator3d& travGen(env.getTravGen());
+    std::vector<StateKey> allKeys;
+    for(const maps::grid::LevelList<traversability_generator3d::TravGenNode*>& l : travGen.getTraversabilityMap())
+    {
+        for(const traversability_generator3d::TravGenNode* n : l)
+        {
+            for(const maps::grid::TraversabilityNodeBase* c : n->getConnections())
+            {
+                const size_t cId = static_cast<const traversability_generator3d::TravGenNode*>(c)->getUserData().id;
+                for(int theta = 0; theta < numAngles; ++theta)
+                    allKeys.push_back(StateKey(cId, theta));
+            }
+        }
+    }
+
+    std::cout << "Map has " << travGen.getNumNodes() << " nodes, the search expanded "
+              << search.getNumExpands() << " states" << std::endl;
+    bool ok = compare("search replay", searchKeys, travGen.getNumNodes(), numAngles);
+    ok &= compare("all orientations of all connected nodes", allKeys, travGen.getNumNodes(), numAngles);
+    return ok ? 0 : 1;
+}
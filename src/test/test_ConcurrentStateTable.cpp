@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE ConcurrentStateTableTestModule
+#include <boost/test/included/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "ugv_nav4d/ConcurrentStateTable.hpp"
+
+using namespace ugv_nav4d;
+
+BOOST_AUTO_TEST_CASE(check_find_or_insert) {
+    ConcurrentStateTable table(8);
+    BOOST_CHECK_EQUAL(table.find(nullptr, 5), -1);
+
+    table.reserve(10);
+    std::atomic<int>* block = table.createBlock();
+    BOOST_CHECK_EQUAL(table.find(block, 5), -1);
+    int numCreated = 0;
+    const int id = table.findOrInsert(block, 5, [&](int) { ++numCreated; });
+    BOOST_CHECK_EQUAL(id, 0);
+    BOOST_CHECK_EQUAL(table.findOrInsert(block, 5, [&](int) { ++numCreated; }), id);
+    BOOST_CHECK_EQUAL(table.findOrInsert(block, 6, [&](int) { ++numCreated; }), 1);
+    BOOST_CHECK_EQUAL(numCreated, 2);
+    BOOST_CHECK_EQUAL(table.find(block, 5), 0);
+    BOOST_CHECK_EQUAL(table.size(), 2u);
+    BOOST_CHECK_EQUAL(table.getNumBlocks(), 1u);
+
+    //the memory of the blocks is reused, new blocks are empty
+    table.clear();
+    BOOST_CHECK_EQUAL(table.size(), 0u);
+    BOOST_CHECK_EQUAL(table.getNumBlocks(), 0u);
+    block = table.createBlock();
+    BOOST_CHECK_EQUAL(table.find(block, 5), -1);
+    BOOST_CHECK_EQUAL(table.find(block, 6), -1);
+}
+
+BOOST_AUTO_TEST_CASE(check_reserve_keeps_ids) {
+    ConcurrentStateTable table(4);
+    table.reserve(1);
+    std::atomic<int>* block = table.createBlock();
+    for(int theta = 0; theta < 4; ++theta)
+        table.findOrInsert(block, theta, [](int) {});
+
+    //the blocks are not moved when new chunks are added
+    table.reserve(100000);
+    BOOST_CHECK_GE(table.getMemoryUsage(), 100000 * 4 * sizeof(std::atomic<int>));
+    for(int theta = 0; theta < 4; ++theta)
+        BOOST_CHECK_EQUAL(table.find(block, theta), theta);
+}
+
+BOOST_AUTO_TEST_CASE(check_concurrent_insert) {
+    const int numNodes = 5000;
+    const int numAngles = 16;
+    const int numStates = numNodes * numAngles;
+    const int numThreads = 4;
+
+    ConcurrentStateTable table(numAngles);
+    table.reserve(numNodes);
+    std::vector<std::atomic<int>*> blocks(numNodes);
+    for(std::atomic<int>*& block : blocks)
+        block = table.createBlock();
+
+    std::vector<std::atomic<int>> createCount(numStates);
+    for(std::atomic<int>& c : createCount)
+        c = 0;
+
+    //every thread requests every state, in a different order
+    std::vector<std::vector<int>> ids(numThreads, std::vector<int>(numStates, -1));
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for(int i = 0; i < numStates; ++i)
+            {
+                const int state = (i + t * numStates / numThreads) % numStates;
+                ids[t][state] = table.findOrInsert(blocks[state / numAngles], state % numAngles, [&](int) { ++createCount[state]; });
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(table.size(), static_cast<size_t>(numStates));
+    std::vector<bool> used(numStates, false);
+    for(int state = 0; state < numStates; ++state)
+    {
+        BOOST_CHECK_EQUAL(createCount[state].load(), 1);
+        const int id = ids[0][state];
+        BOOST_REQUIRE(id >= 0 && id < numStates);
+        BOOST_CHECK(!used[id]);
+        used[id] = true;
+        for(int t = 1; t < numThreads; ++t)
+            BOOST_CHECK_EQUAL(ids[t][state], id);
+    }
+}
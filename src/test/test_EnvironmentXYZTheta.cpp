@@ -9,6 +9,7 @@
 #include <traversability_generator3d/TraversabilityConfig.hpp>
 
 #include <maps/grid/MLSMap.hpp>
+#include <sbpl/utils/mdpconfig.h>
 
 #include <pcl/io/ply_io.h>
 #include <pcl/common/common.h>
@@ -127,4 +128,123 @@ BOOST_AUTO_TEST_CASE(check_planner_init_failure_wrong_grid_resolutions) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(check_clearance_cost) {
+    //flat 12m x 10m plane with a wall parallel to the x axis
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 12.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+        {
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+            if(x >= 1.0 && x < 9.0 && y >= 5.4 && y < 5.7)
+            {
+                for(double z = 0.05; z <= 1.0; z += 0.05)
+                    cloud.push_back(pcl::PointXYZ(x, y, z));
+            }
+        }
+    }
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    mlsMap = maps::grid::MLSMapSloped(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    mlsMap.mergePointCloud(cloud, base::Transform3d::Identity());
+
+    traversabilityConfig.costFunctionDist = 0.6;
+    std::shared_ptr<MLSBase> mlsPtr = std::make_shared<MLSBase>(mlsMap);
+    environment = new EnvironmentXYZTheta(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility);
+    environment->enablePathStatistics(true);
+
+    const Eigen::Vector3d nearWall(3.0, 5.0, 0.0);
+    const Eigen::Vector3d clear(3.0, 3.0, 0.0);
+    environment->expandMap({nearWall, clear});
+
+    //the straight forward motion from @p start, it keeps the distance to the wall
+    auto straightMotion = [&] (const Eigen::Vector3d& start, EnvironmentXYZTheta::SuccessorCandidate& straight)
+    {
+        environment->setStart(start, 0);
+        environment->setGoal(Eigen::Vector3d(10.0, 2.0, 0.0), 0);
+        MDPConfig mdpCfg;
+        BOOST_REQUIRE(environment->InitializeMDPCfg(&mdpCfg));
+
+        std::vector<EnvironmentXYZTheta::SuccessorCandidate> candidates;
+        environment->getSuccessorCandidates(mdpCfg.startstateid, candidates);
+        for(const EnvironmentXYZTheta::SuccessorCandidate& candidate : candidates)
+        {
+            const Motion& motion(*candidate.motion);
+            if(motion.type == Motion::MOV_FORWARD && motion.yDiff == 0 && motion.xDiff > 0 &&
+               motion.endTheta == motion.startTheta)
+            {
+                straight = candidate;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    //within costFunctionDist of the wall the motion is penalized
+    EnvironmentXYZTheta::SuccessorCandidate straight;
+    BOOST_REQUIRE(straightMotion(nearWall, straight));
+    BOOST_CHECK_GT(straight.cost, straight.motion->baseCost);
+
+    //away from all obstacles the motion costs the base cost
+    BOOST_REQUIRE(straightMotion(clear, straight));
+    BOOST_CHECK_EQUAL(straight.cost, straight.motion->baseCost);
+}
+
+BOOST_AUTO_TEST_CASE(check_expand_map_skips_covered_positions) {
+    //two flat platforms that are separated by a gap without measurements
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 12.0; x += 0.05)
+    {
+        if(x >= 5.0 && x < 7.0)
+            continue;
+        for(double y = 0; y < 10.0; y += 0.05)
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+    }
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    mlsMap = maps::grid::MLSMapSloped(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    mlsMap.mergePointCloud(cloud, base::Transform3d::Identity());
+
+    std::shared_ptr<MLSBase> mlsPtr = std::make_shared<MLSBase>(mlsMap);
+    environment = new EnvironmentXYZTheta(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility);
+
+    auto isExpandedAt = [&] (const Eigen::Vector3d& pos)
+    {
+        maps::grid::Index idx;
+        BOOST_REQUIRE(environment->getTravGen().getTraversabilityMap().toGrid(pos, idx));
+        const traversability_generator3d::TravGenNode* node = environment->getTravGen().findMatchingTraversabilityPatchAt(idx, pos.z());
+        return node && node->isExpanded();
+    };
+
+    const Eigen::Vector3d left(2.0, 5.0, 0.0);
+    const Eigen::Vector3d right(9.0, 5.0, 0.0);
+    environment->expandMap({left});
+    BOOST_REQUIRE(isExpandedAt(left));
+    BOOST_REQUIRE(!isExpandedAt(right));
+    const size_t generation = environment->getMapGeneration();
+    const size_t numNodes = environment->getTravGen().getNumNodes();
+
+    //all positions are covered and the map did not change
+    environment->expandMap({left});
+    BOOST_CHECK_EQUAL(environment->getMapGeneration(), generation);
+    BOOST_CHECK_EQUAL(environment->getTravGen().getNumNodes(), numNodes);
+
+    //the right platform is not reachable from the left one, thus it is only expanded from its own seed
+    environment->expandMap({left, right});
+    BOOST_CHECK(isExpandedAt(right));
+    BOOST_CHECK_EQUAL(environment->getMapGeneration(), generation);
+    BOOST_CHECK_GT(environment->getTravGen().getNumNodes(), numNodes);
+
+    //a new map drops all nodes, the same positions have to be expanded again
+    environment->updateMap(mlsPtr);
+    BOOST_CHECK_GT(environment->getMapGeneration(), generation);
+    BOOST_CHECK(!isExpandedAt(left));
+    environment->expandMap({left});
+    BOOST_CHECK(isExpandedAt(left));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
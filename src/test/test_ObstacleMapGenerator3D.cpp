@@ -0,0 +1,128 @@
+#define BOOST_TEST_MODULE ObstacleMapGenerator3DTestModule
+#include <boost/test/included/unit_test.hpp>
+
+#include "ugv_nav4d/ObstacleMapGenerator3D.hpp"
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <maps/grid/MLSMap.hpp>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <cmath>
+
+using namespace ugv_nav4d;
+
+typedef traversability_generator3d::TraversabilityGenerator3d::MLGrid MLSBase;
+
+struct ObstacleMapGenerator3DTest {
+    ObstacleMapGenerator3DTest();
+
+    maps::grid::MLSMapSloped mlsMap;
+    traversability_generator3d::TraversabilityConfig traversabilityConfig;
+};
+
+ObstacleMapGenerator3DTest::ObstacleMapGenerator3DTest() {
+    traversabilityConfig.maxStepHeight = 0.25;
+    traversabilityConfig.maxSlope = 0.45;
+    traversabilityConfig.costFunctionDist = 0.3;
+    traversabilityConfig.minTraversablePercentage = 0.4;
+    traversabilityConfig.robotHeight = 1.2;
+    traversabilityConfig.robotSizeX = 1.35;
+    traversabilityConfig.robotSizeY = 0.85;
+    traversabilityConfig.distToGround = 0.0;
+    traversabilityConfig.gridResolution = 0.3;
+    traversabilityConfig.initialPatchVariance = 0.0001;
+    traversabilityConfig.allowForwardDownhill = true;
+    traversabilityConfig.enableInclineLimitting = false;
+
+    //flat 10m x 10m plane with an overhanging bar at x = 7.05 that the robot cannot pass
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 10.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+        {
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+            if(x > 6.95 && x < 7.15 && y > 3.0 && y < 7.0)
+                cloud.push_back(pcl::PointXYZ(x, y, 0.6));
+        }
+    }
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    mlsMap = maps::grid::MLSMapSloped(maps::grid::Vector2ui(34, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    mlsMap.mergePointCloud(cloud, base::Transform3d::Identity());
+}
+
+BOOST_FIXTURE_TEST_SUITE(ObstacleMapGenerator3DTestSuite, ObstacleMapGenerator3DTest)
+
+BOOST_AUTO_TEST_CASE(check_obstacle_distance_layer) {
+    ObstacleMapGenerator3D obsGen(traversabilityConfig);
+    obsGen.setMLSGrid(std::make_shared<MLSBase>(mlsMap));
+
+    const Eigen::Vector3d start(5.0, 5.0, 0.0);
+    obsGen.expandAll(std::vector<Eigen::Vector3d>{start});
+    const traversability_generator3d::TravGenNode* node = obsGen.generateStartNode(start);
+    BOOST_REQUIRE(node);
+
+    //nodes that are unknown to the layer must not look clear
+    BOOST_CHECK_EQUAL(obsGen.getObstacleDistance(node), 0.0);
+
+    obsGen.updateDistanceLayer();
+    //the node is in cell 16 and the bar in cell 23
+    BOOST_CHECK_CLOSE(obsGen.getObstacleDistance(node), 7 * 0.3, 1e-3);
+    BOOST_CHECK(obsGen.getFrontierDistance(node) > 0);
+
+    //a rebuild from scratch yields the same distances as the incremental update
+    obsGen.clearDistanceLayer();
+    BOOST_CHECK_EQUAL(obsGen.getObstacleDistance(node), 0.0);
+    obsGen.updateDistanceLayer();
+    BOOST_CHECK_CLOSE(obsGen.getObstacleDistance(node), 7 * 0.3, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(check_overhead_clearance) {
+    ObstacleMapGenerator3D obsGen(traversabilityConfig);
+    obsGen.setMLSGrid(std::make_shared<MLSBase>(mlsMap));
+    obsGen.expandAll(std::vector<Eigen::Vector3d>{Eigen::Vector3d(5.0, 5.0, 0.0)});
+
+    //returns the type of the ground node of the cell
+    auto groundType = [&obsGen] (const maps::grid::Index &idx)
+    {
+        for(const traversability_generator3d::TravGenNode *node : obsGen.getTraversabilityMap().at(idx))
+        {
+            if(std::abs(node->getHeight()) < 0.1)
+                return node->getType();
+        }
+        return maps::grid::TraversabilityNodeBase::UNSET;
+    };
+
+    //the bar is between maxStepHeight and robotHeight above the ground
+    BOOST_CHECK_EQUAL(groundType(maps::grid::Index(23, 16)), maps::grid::TraversabilityNodeBase::OBSTACLE);
+    BOOST_CHECK_EQUAL(groundType(maps::grid::Index(21, 16)), maps::grid::TraversabilityNodeBase::TRAVERSABLE);
+    //next to the end of the bar
+    BOOST_CHECK_EQUAL(groundType(maps::grid::Index(23, 25)), maps::grid::TraversabilityNodeBase::TRAVERSABLE);
+
+    //the columns of the old grid must not be used after the grid has been replaced
+    pcl::PointCloud<pcl::PointXYZ> flatCloud;
+    for(double x = 0; x < 10.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+            flatCloud.push_back(pcl::PointXYZ(x, y, 0));
+    }
+    maps::grid::MLSMapSloped flatMap(mlsMap.getNumCells(), mlsMap.getResolution(), mlsMap.getConfig());
+    flatMap.mergePointCloud(flatCloud, base::Transform3d::Identity());
+    obsGen.setMLSGrid(std::make_shared<MLSBase>(flatMap));
+    obsGen.expandAll(std::vector<Eigen::Vector3d>{Eigen::Vector3d(5.0, 5.0, 0.0)});
+    BOOST_CHECK_EQUAL(groundType(maps::grid::Index(23, 16)), maps::grid::TraversabilityNodeBase::TRAVERSABLE);
+
+    //a robot that fits below the bar can pass
+    traversabilityConfig.robotHeight = 0.4;
+    ObstacleMapGenerator3D lowGen(traversabilityConfig);
+    lowGen.setMLSGrid(std::make_shared<MLSBase>(mlsMap));
+    lowGen.expandAll(std::vector<Eigen::Vector3d>{Eigen::Vector3d(5.0, 5.0, 0.0)});
+    for(const traversability_generator3d::TravGenNode *node : lowGen.getTraversabilityMap().at(maps::grid::Index(23, 16)))
+    {
+        if(std::abs(node->getHeight()) < 0.1)
+            BOOST_CHECK_NE(node->getType(), maps::grid::TraversabilityNodeBase::OBSTACLE);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
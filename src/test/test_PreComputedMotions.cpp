@@ -0,0 +1,105 @@
+#define BOOST_TEST_MODULE PreComputedMotionsTestModule
+#include <boost/test/included/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include "ugv_nav4d/PreComputedMotions.hpp"
+
+using namespace ugv_nav4d;
+
+struct PreComputedMotionsTest
+{
+    PreComputedMotionsTest()
+    {
+        splinePrimitiveConfig.gridSize = 0.3;
+        splinePrimitiveConfig.numAngles = 16;
+        splinePrimitiveConfig.numEndAngles = 8;
+        splinePrimitiveConfig.destinationCircleRadius = 5;
+        splinePrimitiveConfig.cellSkipFactor = 3;
+        splinePrimitiveConfig.splineOrder = 4.0;
+
+        mobility.translationSpeed = 0.5;
+        mobility.rotationSpeed = 0.5;
+        mobility.minTurningRadius = 1;
+        mobility.spline_sampling_resolution = 0.05;
+
+        cacheDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(cacheDirectory);
+    }
+
+    ~PreComputedMotionsTest()
+    {
+        boost::filesystem::remove_all(cacheDirectory);
+    }
+
+    sbpl_spline_primitives::SplinePrimitivesConfig splinePrimitiveConfig;
+    Mobility mobility;
+    boost::filesystem::path cacheDirectory;
+};
+
+static void checkEqual(const std::vector<PoseWithCell>& a, const std::vector<PoseWithCell>& b)
+{
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    for(size_t i = 0; i < a.size(); ++i)
+    {
+        BOOST_CHECK(a[i].cell == b[i].cell);
+        BOOST_CHECK_EQUAL(a[i].pose.position.x(), b[i].pose.position.x());
+        BOOST_CHECK_EQUAL(a[i].pose.position.y(), b[i].pose.position.y());
+        BOOST_CHECK_EQUAL(a[i].pose.orientation, b[i].pose.orientation);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(PreComputedMotionsTestSuite, PreComputedMotionsTest)
+
+BOOST_AUTO_TEST_CASE(check_cached_motions_are_equal) {
+    PreComputedMotions computed(splinePrimitiveConfig, mobility);
+    computed.setCacheDirectory(cacheDirectory.string());
+    computed.computeMotions(0.3, 0.3);
+    BOOST_REQUIRE(!boost::filesystem::is_empty(cacheDirectory));
+
+    PreComputedMotions loaded(splinePrimitiveConfig, mobility);
+    loaded.setCacheDirectory(cacheDirectory.string());
+    loaded.computeMotions(0.3, 0.3);
+
+    for(int theta = 0; theta < splinePrimitiveConfig.numAngles; ++theta)
+    {
+        const DiscreteTheta discreteTheta(theta, splinePrimitiveConfig.numAngles);
+        const std::vector<Motion>& expected = computed.getMotionForStartTheta(discreteTheta);
+        const std::vector<Motion>& actual = loaded.getMotionForStartTheta(discreteTheta);
+        BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+        for(size_t i = 0; i < expected.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(expected[i].id, actual[i].id);
+            BOOST_CHECK_EQUAL(expected[i].xDiff, actual[i].xDiff);
+            BOOST_CHECK_EQUAL(expected[i].yDiff, actual[i].yDiff);
+            BOOST_CHECK(expected[i].endTheta == actual[i].endTheta);
+            BOOST_CHECK_EQUAL(expected[i].type, actual[i].type);
+            BOOST_CHECK_EQUAL(expected[i].baseCost, actual[i].baseCost);
+            BOOST_CHECK_EQUAL(expected[i].translationlDist, actual[i].translationlDist);
+            checkEqual(expected[i].intermediateStepsTravMap, actual[i].intermediateStepsTravMap);
+            checkEqual(expected[i].intermediateStepsObstMap, actual[i].intermediateStepsObstMap);
+            BOOST_CHECK_EQUAL(expected[i].fullSplineSamples.size(), actual[i].fullSplineSamples.size());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_cache_is_not_used_for_other_config) {
+    PreComputedMotions computed(splinePrimitiveConfig, mobility);
+    computed.setCacheDirectory(cacheDirectory.string());
+    computed.computeMotions(0.3, 0.3);
+
+    //a different speed changes the costs, the motions have to be computed again
+    mobility.translationSpeed = 1.0;
+    PreComputedMotions other(splinePrimitiveConfig, mobility);
+    other.setCacheDirectory(cacheDirectory.string());
+    other.computeMotions(0.3, 0.3);
+
+    const DiscreteTheta theta(0, splinePrimitiveConfig.numAngles);
+    const Motion& slow = computed.getMotionForStartTheta(theta).front();
+    const Motion& fast = other.getMotionForStartTheta(theta).front();
+    BOOST_CHECK_NE(slow.baseCost, fast.baseCost);
+
+    size_t numFiles = std::distance(boost::filesystem::directory_iterator(cacheDirectory), boost::filesystem::directory_iterator());
+    BOOST_CHECK_EQUAL(numFiles, 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
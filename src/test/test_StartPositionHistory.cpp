@@ -0,0 +1,71 @@
+#define BOOST_TEST_MODULE StartPositionHistoryTestModule
+#include <boost/test/included/unit_test.hpp>
+
+#include "ugv_nav4d/StartPositionHistory.hpp"
+
+using namespace ugv_nav4d;
+
+BOOST_AUTO_TEST_CASE(check_deduplication) {
+    StartPositionHistory history(0.3, 10);
+    BOOST_CHECK(history.add(Eigen::Vector3d(1.0, 1.0, 0.0)));
+    //same cell, the newer position replaces the old one
+    BOOST_CHECK(!history.add(Eigen::Vector3d(1.1, 1.1, 0.1)));
+    BOOST_CHECK_EQUAL(history.size(), 1u);
+    BOOST_CHECK(history.getPositions().front().isApprox(Eigen::Vector3d(1.1, 1.1, 0.1)));
+
+    //same x/y but a different level
+    BOOST_CHECK(history.add(Eigen::Vector3d(1.1, 1.1, 3.0)));
+    BOOST_CHECK_EQUAL(history.size(), 2u);
+
+    history.clear();
+    BOOST_CHECK_EQUAL(history.size(), 0u);
+    BOOST_CHECK(history.getPositions().empty());
+}
+
+BOOST_AUTO_TEST_CASE(check_lru_eviction) {
+    StartPositionHistory history(1.0, 3);
+    history.add(Eigen::Vector3d(0.5, 0.5, 0));
+    history.add(Eigen::Vector3d(1.5, 0.5, 0));
+    history.add(Eigen::Vector3d(2.5, 0.5, 0));
+    //touch the oldest cell, thus the second one becomes the least recently used
+    history.add(Eigen::Vector3d(0.6, 0.6, 0));
+    history.add(Eigen::Vector3d(3.5, 0.5, 0));
+
+    const std::vector<Eigen::Vector3d> positions = history.getPositions();
+    BOOST_REQUIRE_EQUAL(positions.size(), 3u);
+    BOOST_CHECK(positions[0].isApprox(Eigen::Vector3d(3.5, 0.5, 0)));
+    BOOST_CHECK(positions[1].isApprox(Eigen::Vector3d(0.6, 0.6, 0)));
+    BOOST_CHECK(positions[2].isApprox(Eigen::Vector3d(2.5, 0.5, 0)));
+
+    //the evicted cell is new again
+    BOOST_CHECK(history.add(Eigen::Vector3d(1.5, 0.5, 0)));
+    BOOST_CHECK_EQUAL(history.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(check_unbounded) {
+    StartPositionHistory history(0.5, 0);
+    for(int i = 0; i < 1000; ++i)
+        history.add(Eigen::Vector3d(i, 0, 0));
+    BOOST_CHECK_EQUAL(history.size(), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(check_reconfiguration) {
+    StartPositionHistory history(1.0, 0);
+    for(int i = 0; i < 5; ++i)
+        history.add(Eigen::Vector3d(i + 0.5, 0.5, 0));
+
+    //the least recently used positions are dropped
+    history.setCapacity(2);
+    std::vector<Eigen::Vector3d> positions = history.getPositions();
+    BOOST_REQUIRE_EQUAL(positions.size(), 2u);
+    BOOST_CHECK(positions[0].isApprox(Eigen::Vector3d(4.5, 0.5, 0)));
+    BOOST_CHECK(positions[1].isApprox(Eigen::Vector3d(3.5, 0.5, 0)));
+    history.add(Eigen::Vector3d(0.5, 0.5, 0));
+    BOOST_CHECK_EQUAL(history.size(), 2u);
+
+    history.setCellSize(0.5);
+    BOOST_CHECK_EQUAL(history.size(), 0u);
+    BOOST_CHECK(history.add(Eigen::Vector3d(0.1, 0.1, 0)));
+    BOOST_CHECK(history.add(Eigen::Vector3d(0.6, 0.1, 0)));
+    BOOST_CHECK_THROW(history.setCellSize(0), std::runtime_error);
+}
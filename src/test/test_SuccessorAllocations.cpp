@@ -0,0 +1,199 @@
+#define BOOST_TEST_MODULE SuccessorAllocationsTestModule
+#include <boost/test/included/unit_test.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "ugv_nav4d/EnvironmentXYZTheta.hpp"
+#include "ugv_nav4d/Mobility.hpp"
+#include <sbpl/utils/mdpconfig.h>
+#include <sbpl_spline_primitives/SplinePrimitivesConfig.hpp>
+#include <traversability_generator3d/TraversabilityConfig.hpp>
+#include <maps/grid/MLSMap.hpp>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <omp.h>
+
+using namespace ugv_nav4d;
+
+// Count all heap allocations while countAllocations is true
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<bool> countAllocations(false);
+
+void* operator new(std::size_t size)
+{
+    if(countAllocations)
+        ++allocationCount;
+    void* p = std::malloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+struct SuccessorAllocationsTest {
+    SuccessorAllocationsTest();
+
+    typedef EnvironmentXYZTheta::MLGrid MLSBase;
+
+    maps::grid::MLSMapSloped mlsMap;
+    Mobility mobility;
+    sbpl_spline_primitives::SplinePrimitivesConfig splinePrimitiveConfig;
+    traversability_generator3d::TraversabilityConfig traversabilityConfig;
+};
+
+SuccessorAllocationsTest::SuccessorAllocationsTest() {
+    splinePrimitiveConfig.gridSize = 0.3;
+    splinePrimitiveConfig.numAngles = 16;
+    splinePrimitiveConfig.numEndAngles = 8;
+    splinePrimitiveConfig.destinationCircleRadius = 6;
+    splinePrimitiveConfig.cellSkipFactor = 0.1;
+    splinePrimitiveConfig.splineOrder = 4.0;
+
+    mobility.translationSpeed = 0.5;
+    mobility.rotationSpeed = 0.5;
+    mobility.minTurningRadius = 1;
+    mobility.spline_sampling_resolution = 0.05;
+    mobility.remove_goal_offset = true;
+    mobility.searchRadius = 0.0;
+    mobility.maxMotionCurveLength = 100;
+
+    traversabilityConfig.maxStepHeight = 0.25;
+    traversabilityConfig.maxSlope = 0.45;
+    traversabilityConfig.inclineLimittingMinSlope = 0.2;
+    traversabilityConfig.inclineLimittingLimit = 0.1;
+    traversabilityConfig.costFunctionDist = 0.3;
+    traversabilityConfig.minTraversablePercentage = 0.4;
+    traversabilityConfig.robotHeight = 1.2;
+    traversabilityConfig.robotSizeX = 1.35;
+    traversabilityConfig.robotSizeY = 0.85;
+    traversabilityConfig.distToGround = 0.0;
+    traversabilityConfig.slopeMetricScale = 1.0;
+    traversabilityConfig.slopeMetric = traversability_generator3d::NONE;
+    traversabilityConfig.gridResolution = 0.3;
+    traversabilityConfig.initialPatchVariance = 0.0001;
+    traversabilityConfig.allowForwardDownhill = true;
+    traversabilityConfig.enableInclineLimitting = false;
+
+    //flat 10m x 10m plane
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 10.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+        {
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+        }
+    }
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    mlsMap = maps::grid::MLSMapSloped(maps::grid::Vector2ui(34, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    mlsMap.mergePointCloud(cloud, base::Transform3d::Identity());
+}
+
+BOOST_FIXTURE_TEST_SUITE(SuccessorAllocationsTestSuite, SuccessorAllocationsTest)
+
+BOOST_AUTO_TEST_CASE(check_get_succs_does_not_allocate) {
+    omp_set_num_threads(1);
+
+    std::shared_ptr<MLSBase> mlsPtr = std::make_shared<MLSBase>(mlsMap);
+    EnvironmentXYZTheta environment(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility);
+    environment.enablePathStatistics(true);
+
+    const Eigen::Vector3d start(5.0, 5.0, 0.0);
+    const Eigen::Vector3d goal(7.0, 5.0, 0.0);
+    environment.expandMap({start});
+    environment.setStart(start, 0);
+    environment.setGoal(goal, 0);
+
+    MDPConfig mdpCfg;
+    BOOST_REQUIRE(environment.InitializeMDPCfg(&mdpCfg));
+
+    std::vector<int> succIds;
+    std::vector<int> costs;
+    std::vector<size_t> motionIds;
+    succIds.reserve(1000);
+    costs.reserve(1000);
+    motionIds.reserve(1000);
+
+    //the first expansion creates the successor states and warms up the scratch buffers
+    environment.GetSuccs(mdpCfg.startstateid, &succIds, &costs, motionIds);
+    BOOST_REQUIRE(!succIds.empty());
+
+    //Measure the expansion of a successor that has not been expanded yet. It has the same orientation as the start, thus the
+    //scratch buffers have already seen all of its motions.
+    int freshStateId = -1;
+    for(size_t i = 0; i < succIds.size(); ++i)
+    {
+        const Motion& motion = environment.getAvailableMotions().getMotion(motionIds[i]);
+        if(succIds[i] != mdpCfg.startstateid && motion.endTheta == motion.startTheta)
+        {
+            freshStateId = succIds[i];
+            break;
+        }
+    }
+    BOOST_REQUIRE(freshStateId >= 0);
+
+    //the storage of the new states is reserved beforehand, like the search does for a whole batch
+    environment.reserveStates(1000);
+
+    allocationCount = 0;
+    countAllocations = true;
+    environment.GetSuccs(freshStateId, &succIds, &costs, motionIds);
+    countAllocations = false;
+
+    BOOST_CHECK(!succIds.empty());
+    BOOST_CHECK_EQUAL(allocationCount.load(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(check_cached_motion_checks_keep_costs) {
+    //a wall next to the start, thus the obstacle checks reject or penalize some of the motions
+    pcl::PointCloud<pcl::PointXYZ> wall;
+    for(double y = 4.0; y < 6.0; y += 0.05)
+    {
+        for(double z = 0; z < 1.0; z += 0.05)
+        {
+            wall.push_back(pcl::PointXYZ(6.0, y, z));
+        }
+    }
+    mlsMap.mergePointCloud(wall, base::Transform3d::Identity());
+
+    std::shared_ptr<MLSBase> mlsPtr = std::make_shared<MLSBase>(mlsMap);
+    EnvironmentXYZTheta environment(mlsPtr, traversabilityConfig, splinePrimitiveConfig, mobility);
+
+    const Eigen::Vector3d start(5.0, 5.0, 0.0);
+    environment.expandMap({start});
+    environment.setStart(start, 0);
+    environment.setGoal(Eigen::Vector3d(3.0, 5.0, 0.0), 0);
+
+    MDPConfig mdpCfg;
+    BOOST_REQUIRE(environment.InitializeMDPCfg(&mdpCfg));
+
+    //the first call checks the motions on the obstacle map, the second one uses the cached checks
+    std::vector<EnvironmentXYZTheta::SuccessorCandidate> checked;
+    std::vector<EnvironmentXYZTheta::SuccessorCandidate> cached;
+    environment.getSuccessorCandidates(mdpCfg.startstateid, checked);
+    environment.getSuccessorCandidates(mdpCfg.startstateid, cached);
+
+    BOOST_REQUIRE(!checked.empty());
+    BOOST_REQUIRE_EQUAL(checked.size(), cached.size());
+    for(size_t i = 0; i < checked.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(checked[i].motion->id, cached[i].motion->id);
+        BOOST_CHECK(checked[i].travNode == cached[i].travNode);
+        BOOST_CHECK_EQUAL(checked[i].cost, cached[i].cost);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
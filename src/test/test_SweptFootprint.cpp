@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE SweptFootprintTestModule
+#include <boost/test/included/unit_test.hpp>
+
+#include "ugv_nav4d/SweptFootprint.hpp"
+#include "ugv_nav4d/PreComputedMotions.hpp"
+#include <cmath>
+
+using namespace ugv_nav4d;
+
+static traversability_generator3d::TraversabilityConfig createConfig()
+{
+    traversability_generator3d::TraversabilityConfig config;
+    config.gridResolution = 0.3;
+    config.robotSizeX = 1.0;
+    config.robotSizeY = 0.4;
+    config.costFunctionDist = 0.3;
+    return config;
+}
+
+static PoseWithCell createStep(double x, double y, double theta, int cellX, int cellY)
+{
+    PoseWithCell step;
+    step.pose.position = Eigen::Vector2d(x, y);
+    step.pose.orientation = theta;
+    step.cell = maps::grid::Index(cellX, cellY);
+    return step;
+}
+
+/** @return the extent of the cells inside the robot, (max |x|, max |y|) */
+static maps::grid::Index robotExtent(const SweptFootprint& footprint, size_t& numRobotCells)
+{
+    maps::grid::Index extent(0, 0);
+    numRobotCells = 0;
+    for(const SweptFootprint::Cell& cell : footprint.getCells())
+    {
+        if(!cell.isInsideRobot())
+            continue;
+        ++numRobotCells;
+        extent.x() = std::max(extent.x(), std::abs(cell.offset.x()));
+        extent.y() = std::max(extent.y(), std::abs(cell.offset.y()));
+    }
+    return extent;
+}
+
+BOOST_AUTO_TEST_CASE(check_single_pose) {
+    const SweptFootprint footprint({createStep(0, 0, 0, 0, 0)}, createConfig());
+
+    size_t numRobotCells = 0;
+    const maps::grid::Index extent = robotExtent(footprint, numRobotCells);
+    //a cell is inside the robot if one of its corners is inside the robot box
+    BOOST_CHECK_EQUAL(numRobotCells, 15u);
+    BOOST_CHECK_EQUAL(extent.x(), 2);
+    BOOST_CHECK_EQUAL(extent.y(), 1);
+
+    size_t numBoundaryCells = 0;
+    for(const SweptFootprint::Cell& cell : footprint.getCells())
+    {
+        if(cell.isInsideBoundary())
+        {
+            ++numBoundaryCells;
+            //the corridor is a box, thus its corners are further away than costFunctionDist
+            BOOST_CHECK(cell.boundaryDistance <= 0.3 * std::sqrt(2.0) + 1e-9);
+        }
+        if(cell.offset == maps::grid::Index(0, 0))
+            BOOST_CHECK_SMALL(cell.robotDistance, 1e-9);
+        if(cell.offset == maps::grid::Index(2, 0))
+            BOOST_CHECK_CLOSE(cell.robotDistance, 0.6, 1e-6);
+    }
+    BOOST_CHECK(numBoundaryCells > 0);
+}
+
+BOOST_AUTO_TEST_CASE(check_rotation_and_sweep) {
+    const SweptFootprint rotated({createStep(0, 0, M_PI / 2.0, 0, 0)}, createConfig());
+    size_t numRobotCells = 0;
+    maps::grid::Index extent = robotExtent(rotated, numRobotCells);
+    BOOST_CHECK_EQUAL(numRobotCells, 15u);
+    BOOST_CHECK_EQUAL(extent.x(), 1);
+    BOOST_CHECK_EQUAL(extent.y(), 2);
+
+    //moving one cell forward adds one column of cells
+    const SweptFootprint swept({createStep(0, 0, 0, 0, 0), createStep(0.3, 0, 0, 1, 0)}, createConfig());
+    robotExtent(swept, numRobotCells);
+    BOOST_CHECK_EQUAL(numRobotCells, 18u);
+}
+
+BOOST_AUTO_TEST_CASE(check_breadth_first_order) {
+    const SweptFootprint footprint({createStep(0, 0, 0.3, 0, 0), createStep(0.3, 0.1, 0.5, 1, 0)}, createConfig());
+    const std::vector<SweptFootprint::Cell>& cells = footprint.getCells();
+    BOOST_REQUIRE(!cells.empty());
+    BOOST_CHECK(cells.front().offset == maps::grid::Index(0, 0));
+    BOOST_CHECK_EQUAL(cells.front().numParents, 0);
+
+    for(size_t i = 1; i < cells.size(); ++i)
+    {
+        //every cell can be reached via a neighbor that has been visited before
+        BOOST_REQUIRE(cells[i].numParents > 0);
+        for(uint8_t p = 0; p < cells[i].numParents; ++p)
+        {
+            BOOST_CHECK(cells[i].parents[p] < i);
+            const maps::grid::Index diff = cells[i].offset - cells[cells[i].parents[p]].offset;
+            BOOST_CHECK(std::abs(diff.x()) <= 1 && std::abs(diff.y()) <= 1);
+        }
+    }
+
+    BOOST_CHECK(SweptFootprint({}, createConfig()).empty());
+}
@@ -1,6 +1,7 @@
 #define BOOST_TEST_MODULE PlannerTestModule
 #include <boost/test/included/unit_test.hpp>
 
+#include <cmath>
 #include <fstream>
 #include <cstdlib>
 
@@ -236,6 +237,244 @@ BOOST_AUTO_TEST_CASE(check_planner_success) {
     BOOST_CHECK_EQUAL(result, Planner::FOUND_SOLUTION);
 }
 
+BOOST_AUTO_TEST_CASE(check_planner_region_update) {
+    //flat 12m x 10m plane, a wall is inserted between start and goal later on
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 12.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+    }
+    const Eigen::AlignedBox3d wall(Eigen::Vector3d(5.9, 3.5, 0.0), Eigen::Vector3d(6.3, 6.5, 1.0));
+    pcl::PointCloud<pcl::PointXYZ> wallCloud;
+    for(double x = wall.min().x(); x < wall.max().x(); x += 0.05)
+    {
+        for(double y = wall.min().y(); y < wall.max().y(); y += 0.05)
+        {
+            for(double z = wall.min().z(); z <= wall.max().z(); z += 0.05)
+                wallCloud.push_back(pcl::PointXYZ(x, y, z));
+        }
+    }
+
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped flatMap(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    flatMap.mergePointCloud(cloud, base::Transform3d::Identity());
+    maps::grid::MLSMapSloped wallMap(flatMap);
+    wallMap.mergePointCloud(wallCloud, base::Transform3d::Identity());
+
+    planner = new Planner(splinePrimitiveConfig, traversabilityConfig, mobility, plannerConfig);
+    planner->updateMap(flatMap);
+
+    base::samples::RigidBodyState startState;
+    startState.position = Eigen::Vector3d(2.0, 5.0, 0.0);
+    startState.orientation.setIdentity();
+    base::samples::RigidBodyState endState;
+    endState.position = Eigen::Vector3d(10.0, 5.0, 0.0);
+    endState.orientation.setIdentity();
+
+    //true if the center of the robot comes closer than half of its width to the wall
+    const double margin = traversabilityConfig.robotSizeY / 2.0;
+    const Eigen::AlignedBox2d blocked(wall.min().head<2>() - Eigen::Vector2d::Constant(margin),
+                                      wall.max().head<2>() + Eigen::Vector2d::Constant(margin));
+    auto crossesWall = [&blocked] (const std::vector<trajectory_follower::SubTrajectory>& trajectory)
+    {
+        for(const trajectory_follower::SubTrajectory& part : trajectory)
+        {
+            const double step = (part.posSpline.getEndParam() - part.posSpline.getStartParam()) / 50.0;
+            for(int i = 0; i <= 50; ++i)
+            {
+                const base::Vector3d pos = part.posSpline.getPoint(part.posSpline.getStartParam() + i * step);
+                if(blocked.contains(pos.head<2>()))
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<trajectory_follower::SubTrajectory> trajectory2D;
+    std::vector<trajectory_follower::SubTrajectory> trajectory3D;
+    Planner::PLANNING_RESULT result = planner->plan(base::Time::fromSeconds(5), startState, endState, trajectory2D, trajectory3D);
+    BOOST_REQUIRE_EQUAL(result, Planner::FOUND_SOLUTION);
+    //on the empty plane the straight path goes through the area of the wall
+    BOOST_CHECK(crossesWall(trajectory2D));
+
+    planner->updateMap(wallMap, wall);
+    result = planner->plan(base::Time::fromSeconds(5), startState, endState, trajectory2D, trajectory3D);
+    BOOST_REQUIRE_EQUAL(result, Planner::FOUND_SOLUTION);
+    BOOST_CHECK(!crossesWall(trajectory2D));
+
+    //raise a strip of the ground in front of the wall by less than the step height.
+    //The nodes of the strip have to be generated again, otherwise they keep the old height
+    const Eigen::AlignedBox3d raised(Eigen::Vector3d(3.5, 0.0, 0.0), Eigen::Vector3d(5.0, 10.0, 0.15));
+    pcl::PointCloud<pcl::PointXYZ> raisedCloud(wallCloud);
+    for(const pcl::PointXYZ& p : cloud)
+    {
+        const bool inStrip = p.x >= raised.min().x() && p.x < raised.max().x();
+        raisedCloud.push_back(pcl::PointXYZ(p.x, p.y, inStrip ? raised.max().z() : 0.0));
+    }
+    maps::grid::MLSMapSloped raisedMap(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    raisedMap.mergePointCloud(raisedCloud, base::Transform3d::Identity());
+
+    planner->updateMap(raisedMap, raised);
+    result = planner->plan(base::Time::fromSeconds(5), startState, endState, trajectory2D, trajectory3D);
+    BOOST_REQUIRE_EQUAL(result, Planner::FOUND_SOLUTION);
+    BOOST_CHECK(!crossesWall(trajectory2D));
+
+    //every path from start to goal crosses the strip, away from its edges the path is on the new surface
+    size_t numOnStrip = 0;
+    for(const trajectory_follower::SubTrajectory& part : trajectory3D)
+    {
+        const double step = (part.posSpline.getEndParam() - part.posSpline.getStartParam()) / 50.0;
+        for(int i = 0; i <= 50; ++i)
+        {
+            const base::Vector3d pos = part.posSpline.getPoint(part.posSpline.getStartParam() + i * step);
+            if(pos.x() > raised.min().x() + 0.4 && pos.x() < raised.max().x() - 0.4)
+            {
+                BOOST_CHECK_CLOSE_FRACTION(pos.z(), raised.max().z(), 0.3);
+                ++numOnStrip;
+            }
+        }
+    }
+    BOOST_CHECK_GT(numOnStrip, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(check_planner_multiple_goals) {
+    //flat 12m x 10m plane with a closed ring of walls around (9.5, 7.5)
+    const Eigen::AlignedBox2d outside(Eigen::Vector2d(8.3, 6.3), Eigen::Vector2d(10.7, 8.7));
+    const Eigen::AlignedBox2d inside(Eigen::Vector2d(8.6, 6.6), Eigen::Vector2d(10.4, 8.4));
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 12.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+        {
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+            if(outside.contains(Eigen::Vector2d(x, y)) && !inside.contains(Eigen::Vector2d(x, y)))
+            {
+                for(double z = 0.05; z <= 1.0; z += 0.05)
+                    cloud.push_back(pcl::PointXYZ(x, y, z));
+            }
+        }
+    }
+
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped map(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    map.mergePointCloud(cloud, base::Transform3d::Identity());
+
+    planner = new Planner(splinePrimitiveConfig, traversabilityConfig, mobility, plannerConfig);
+    planner->updateMap(map);
+
+    auto pose = [] (double x, double y)
+    {
+        base::samples::RigidBodyState state;
+        state.position = Eigen::Vector3d(x, y, 0.0);
+        state.orientation.setIdentity();
+        return state;
+    };
+    const base::samples::RigidBodyState startState = pose(2.0, 3.0);
+    //inside the ring, far, near, in between
+    const std::vector<base::samples::RigidBodyState> goals = {pose(9.5, 7.5), pose(10.0, 2.0), pose(4.0, 3.0), pose(7.0, 3.0)};
+
+    std::vector<Planner::GoalResult> results = planner->planToGoals(base::Time::fromSeconds(5), startState, goals, true);
+    BOOST_REQUIRE_EQUAL(results.size(), goals.size());
+    BOOST_CHECK_EQUAL(results[0].result, Planner::GOAL_INVALID);
+    for(size_t i = 1; i < results.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(results[i].result, Planner::FOUND_SOLUTION);
+        //the estimate is a lower bound of the travel time
+        BOOST_CHECK_GE(results[i].cost, results[i].estimatedCost);
+        BOOST_CHECK(!results[i].trajectory2D.empty());
+    }
+    BOOST_CHECK_LT(results[2].estimatedCost, results[3].estimatedCost);
+    BOOST_CHECK_LT(results[3].estimatedCost, results[1].estimatedCost);
+
+    size_t goalIndex = goals.size();
+    std::vector<trajectory_follower::SubTrajectory> trajectory2D;
+    std::vector<trajectory_follower::SubTrajectory> trajectory3D;
+    const Planner::PLANNING_RESULT result = planner->planToNearestGoal(base::Time::fromSeconds(5), startState, goals, goalIndex,
+                                                                       trajectory2D, trajectory3D);
+    BOOST_REQUIRE_EQUAL(result, Planner::FOUND_SOLUTION);
+    BOOST_CHECK_EQUAL(goalIndex, 2u);
+    BOOST_CHECK(!trajectory2D.empty());
+    BOOST_CHECK_GE(planner->getSolutionCost(), results[2].estimatedCost);
+}
+
+BOOST_AUTO_TEST_CASE(check_planner_travel_times) {
+    //flat 12m x 10m plane with a wall on the upper half
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for(double x = 0; x < 12.0; x += 0.05)
+    {
+        for(double y = 0; y < 10.0; y += 0.05)
+        {
+            cloud.push_back(pcl::PointXYZ(x, y, 0));
+            if(x >= 6.0 && x < 6.3 && y >= 5.0)
+            {
+                for(double z = 0.05; z <= 1.0; z += 0.05)
+                    cloud.push_back(pcl::PointXYZ(x, y, z));
+            }
+        }
+    }
+
+    maps::grid::MLSConfig cfg;
+    cfg.gapSize = 0.1;
+    cfg.thickness = 0.1;
+    cfg.useColor = false;
+    maps::grid::MLSMapSloped map(maps::grid::Vector2ui(40, 34), maps::grid::Vector2d(0.3, 0.3), cfg);
+    map.mergePointCloud(cloud, base::Transform3d::Identity());
+
+    planner = new Planner(splinePrimitiveConfig, traversabilityConfig, mobility, plannerConfig);
+    planner->updateMap(map);
+
+    base::samples::RigidBodyState startState;
+    startState.position = Eigen::Vector3d(2.0, 3.0, 0.0);
+    startState.orientation.setIdentity();
+    std::vector<double> travelTimes;
+    BOOST_REQUIRE_EQUAL(planner->computeTravelTimes(startState, travelTimes), Planner::FOUND_SOLUTION);
+
+    const maps::grid::TraversabilityMap3d<traversability_generator3d::TravGenNode*>& trMap = planner->getTraversabilityMap();
+    maps::grid::Index startIdx;
+    BOOST_REQUIRE(trMap.toGrid(startState.position, startIdx));
+
+    //along the row of the start the travel time grows with the distance
+    double previous = -1;
+    size_t numTraversable = 0;
+    for(int x = startIdx.x(); x < (int)trMap.getNumCells().x(); ++x)
+    {
+        for(const traversability_generator3d::TravGenNode* node : trMap.at(maps::grid::Index(x, startIdx.y())))
+        {
+            if(node->getType() != maps::grid::TraversabilityNodeBase::TRAVERSABLE)
+                continue;
+            BOOST_REQUIRE_LT(node->getUserData().id, travelTimes.size());
+            const double time = travelTimes[node->getUserData().id];
+            BOOST_CHECK(std::isfinite(time));
+            BOOST_CHECK_GT(time, previous);
+            previous = time;
+            ++numTraversable;
+        }
+    }
+    BOOST_CHECK_GT(numTraversable, 20u);
+
+    //the patches of the wall cannot be reached
+    size_t numObstacles = 0;
+    for(const maps::grid::LevelList<traversability_generator3d::TravGenNode*>& level : trMap)
+    {
+        for(const traversability_generator3d::TravGenNode* node : level)
+        {
+            if(node->getType() != maps::grid::TraversabilityNodeBase::OBSTACLE)
+                continue;
+            BOOST_REQUIRE_LT(node->getUserData().id, travelTimes.size());
+            BOOST_CHECK(std::isinf(travelTimes[node->getUserData().id]));
+            ++numObstacles;
+        }
+    }
+    BOOST_CHECK_GT(numObstacles, 0u);
+}
+
 // DiscreteTheta test
 BOOST_AUTO_TEST_CASE(check_discrete_theta_init) {
     DiscreteTheta theta = DiscreteTheta(0, 16);